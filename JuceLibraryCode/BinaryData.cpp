@@ -0,0 +1,95 @@
+/* ==================================== JUCER_BINARY_RESOURCE ====================================
+
+   This is an auto-generated file: Any edits you make may be overwritten!
+
+*/
+
+namespace BinaryData
+{
+
+//================== ui.zip ==================
+static const unsigned char temp_binary_data_0[] =
+{ 80,75,3,4,20,0,0,0,8,0,0,0,129,76,226,242,38,131,44,1,0,0,8,3,0,0,10,0,0,0,105,110,100,101,120,46,104,116,109,108,157,82,177,78,195,48,20,220,251,21,198,123,200,134,64,114,188,148,22,49,209,74,44,
+140,175,206,107,99,234,58,193,239,53,40,127,143,19,167,8,10,69,45,94,242,116,231,187,179,157,83,87,247,79,211,231,151,197,76,84,188,115,122,162,14,31,132,82,79,68,92,106,135,12,194,84,16,8,185,144,
+123,94,103,183,114,164,216,178,67,61,157,205,23,110,191,121,244,42,79,64,34,157,245,91,17,208,21,146,184,115,72,21,34,75,81,5,92,71,23,123,109,136,162,141,202,83,146,90,213,101,55,10,75,219,10,91,22,
+114,235,235,21,141,81,159,132,113,64,148,56,41,74,96,200,26,8,176,43,228,60,224,155,212,202,128,111,129,196,187,45,185,42,228,221,77,76,68,187,169,120,152,181,202,19,175,21,53,224,117,175,81,249,48,
+170,60,186,159,155,245,0,214,95,154,213,107,254,147,181,188,52,104,249,51,229,235,120,120,93,240,224,58,178,167,30,216,3,219,22,179,24,185,233,127,91,175,112,216,162,27,15,183,181,62,34,177,26,24,228,
+95,247,249,197,134,76,221,224,55,155,132,156,58,112,19,112,208,197,176,96,13,245,251,34,116,116,155,38,212,171,35,11,50,193,54,44,40,152,161,111,175,131,50,129,125,239,82,225,98,255,134,194,127,0,80,
+75,3,4,20,0,0,0,8,0,0,0,129,76,34,150,136,212,133,1,0,0,128,3,0,0,6,0,0,0,117,105,46,99,115,115,165,83,219,78,195,48,12,125,239,87,68,154,120,65,20,178,21,38,84,190,38,77,220,214,44,77,162,36,101,43,
+136,127,199,89,218,193,38,46,15,180,82,149,28,199,62,62,39,110,31,7,125,195,26,171,38,246,86,48,122,6,225,59,52,53,227,79,199,109,15,216,245,177,102,107,206,175,50,210,8,185,235,188,29,141,170,217,
+106,13,235,118,179,201,1,105,181,245,132,41,158,222,140,181,214,164,228,202,29,88,16,38,148,1,60,182,57,52,210,154,246,26,36,157,48,214,192,83,241,94,20,171,157,177,77,152,123,81,24,156,22,83,205,90,
+13,135,156,245,60,134,136,237,84,74,42,12,169,182,164,47,248,28,236,132,171,89,181,113,243,89,39,148,66,211,149,209,18,124,255,152,96,98,184,77,12,63,19,164,85,169,208,83,91,104,201,7,82,53,14,38,199,
+132,198,206,148,24,97,8,231,196,114,244,33,105,39,133,30,2,190,206,90,132,17,122,10,248,47,57,235,237,183,114,178,74,34,185,187,102,202,139,189,97,205,196,98,15,204,233,145,238,239,38,175,69,7,204,26,
+61,177,29,128,11,71,44,56,33,129,93,223,21,43,13,47,160,231,214,246,168,98,79,100,39,239,78,247,190,225,51,209,42,72,235,224,252,124,181,229,191,36,12,16,61,202,69,189,179,1,179,165,162,9,100,106,132,
+156,168,161,165,180,199,165,78,99,99,180,195,23,224,98,32,211,68,149,201,226,52,147,203,25,75,162,48,146,179,252,246,33,115,59,111,27,184,244,61,79,217,223,205,148,213,82,248,232,245,231,118,150,189,
+189,20,125,2,206,126,14,224,130,87,124,33,196,116,177,37,121,110,98,248,28,248,15,80,75,3,4,20,0,0,0,8,0,0,0,129,76,220,159,106,242,133,8,0,0,92,27,0,0,5,0,0,0,117,105,46,106,115,181,89,109,111,27,55,
+18,254,238,95,193,110,129,222,238,89,89,43,73,115,189,88,39,20,137,145,162,189,38,141,17,231,218,26,65,62,80,43,74,98,189,34,247,72,174,101,53,208,127,239,12,95,246,133,187,82,114,31,78,40,98,137,156,
+25,206,235,51,67,246,226,130,252,44,228,66,147,133,172,197,146,24,73,118,92,44,229,46,175,168,162,91,102,152,210,19,178,219,240,98,67,204,134,145,170,172,215,92,16,46,254,96,133,209,240,23,24,216,61,
+83,123,82,209,53,203,207,210,85,45,10,195,165,32,105,70,62,157,17,248,220,83,69,238,236,17,115,242,225,227,236,204,46,54,100,75,69,119,168,64,138,36,129,37,176,21,84,220,83,228,195,205,220,253,154,
+245,41,204,3,108,187,157,124,205,204,149,20,134,61,152,52,121,178,76,178,62,233,61,45,107,6,196,3,251,200,247,195,181,15,246,68,251,251,35,185,36,211,86,20,95,145,212,139,154,123,197,208,6,241,171,93,
+251,230,155,160,204,142,47,205,38,162,249,205,174,181,52,27,198,215,27,19,17,253,104,23,187,174,192,143,98,166,86,162,85,227,208,124,139,85,152,59,75,103,35,4,238,252,121,79,197,49,186,31,189,94,125,
+61,125,232,130,63,181,161,10,105,166,249,119,207,200,223,201,27,106,54,249,245,79,125,159,51,72,169,185,167,60,39,143,243,14,33,124,139,244,68,6,21,105,71,46,200,19,242,136,252,179,115,54,132,60,47,
+74,70,213,59,72,193,116,58,33,240,95,151,101,210,215,186,147,5,200,89,114,193,130,27,254,49,220,186,162,21,108,36,10,139,33,233,111,107,163,228,29,187,49,251,18,125,156,124,253,148,62,45,190,125,18,
+17,45,24,148,199,53,88,152,70,231,82,85,164,177,97,145,166,110,73,77,156,191,38,227,110,203,198,148,138,15,139,85,101,83,58,125,58,253,63,170,10,113,62,169,216,193,133,239,226,130,188,7,16,217,72,109,
+8,173,141,220,82,195,52,233,84,226,142,155,141,172,13,49,172,132,104,172,29,228,0,176,192,65,210,165,139,38,84,177,32,172,216,176,226,142,45,61,2,173,80,76,78,222,138,114,79,168,205,102,224,167,6,168,
+168,88,3,21,215,22,109,196,132,80,65,0,127,220,114,144,133,199,192,63,128,104,154,8,105,54,120,60,69,68,108,81,15,92,96,53,35,220,160,48,190,44,1,241,144,189,135,102,47,202,50,237,86,175,197,190,124,
+37,213,43,90,108,210,128,119,29,119,121,240,81,236,191,96,158,121,33,56,184,5,132,253,128,230,164,94,98,223,143,75,89,212,91,38,76,14,28,106,127,195,74,168,4,169,240,224,36,199,227,146,172,57,175,197,
+99,160,66,158,24,99,173,159,230,228,147,11,195,37,241,100,249,146,26,170,153,113,24,24,194,223,110,247,78,78,19,183,157,100,228,48,139,12,175,106,189,113,224,222,169,225,32,133,46,151,175,238,225,203,
+107,174,13,19,12,4,109,101,173,25,184,67,36,147,214,173,41,46,196,136,216,96,208,45,168,143,4,128,10,28,100,221,206,198,201,126,61,134,255,93,172,239,232,216,11,236,86,222,179,148,197,42,4,249,161,
+181,216,26,221,114,145,62,158,248,239,244,1,17,170,115,254,57,73,189,210,143,8,11,26,103,88,79,211,105,150,205,6,226,79,119,166,1,214,187,36,25,53,161,174,210,49,253,155,236,67,19,199,130,129,235,16,
+12,252,115,92,191,227,236,117,5,204,117,149,157,210,209,11,57,146,13,199,21,56,205,55,60,249,16,202,40,228,34,212,253,59,128,65,41,116,183,206,177,230,0,4,160,10,239,89,185,247,136,2,251,92,145,146,
+238,17,159,214,146,33,7,180,137,181,157,139,186,32,18,198,37,104,81,247,150,138,109,9,219,86,102,111,225,100,9,156,226,111,6,250,185,197,26,164,5,144,6,34,220,198,202,247,144,130,105,5,232,11,35,141,
+182,233,125,188,224,157,158,143,28,113,24,122,144,125,201,138,18,192,18,59,112,226,177,191,5,42,183,247,155,59,161,151,24,56,224,124,229,61,11,0,240,139,21,239,9,191,124,42,65,5,74,136,135,31,250,218,
+136,89,57,95,6,79,65,142,2,107,65,78,0,13,16,240,18,251,51,32,244,149,173,31,59,8,68,169,129,103,59,236,249,4,64,221,226,22,95,78,200,29,24,55,4,58,92,157,12,242,59,124,30,46,173,26,121,201,86,208,
+239,246,254,151,145,213,132,216,38,233,23,252,4,226,186,164,95,243,45,243,48,146,136,193,194,63,52,184,96,78,254,125,243,246,23,236,156,96,25,95,237,83,180,161,67,136,129,177,132,95,193,188,24,130,27,
+251,171,19,116,164,29,173,151,56,170,241,65,135,179,246,95,60,212,179,189,99,154,255,201,222,46,52,83,208,111,227,62,34,253,58,28,44,216,142,244,137,211,126,190,117,206,10,108,185,255,146,54,169,190,
+144,203,125,246,191,101,206,80,90,216,155,181,181,127,214,241,196,16,57,148,213,27,128,99,84,227,163,108,186,80,178,44,143,177,197,213,54,235,141,67,30,117,182,140,234,90,57,196,32,11,46,40,140,52,56,
+163,8,86,218,185,8,192,101,95,74,186,212,205,84,68,52,204,93,112,115,163,197,93,30,7,203,9,184,114,252,221,88,141,237,231,82,108,153,214,40,114,222,233,186,144,221,188,152,144,69,189,90,245,227,29,
+206,178,4,246,250,146,176,98,35,147,19,253,165,127,30,42,158,58,158,70,254,177,6,113,136,71,200,55,193,81,14,249,222,85,197,37,140,39,101,9,147,36,164,159,102,133,4,156,181,30,131,69,34,87,14,130,185,
+214,53,148,5,204,131,82,20,108,18,132,193,158,176,14,85,238,254,171,120,133,44,82,48,43,19,233,41,49,28,7,203,78,172,74,185,118,97,0,53,234,210,228,221,228,80,181,0,149,94,50,24,48,183,84,221,245,60,
+42,234,237,21,106,26,23,143,170,138,118,50,105,204,234,99,4,240,222,224,136,40,12,167,37,80,195,192,208,39,8,23,50,240,2,20,201,150,130,153,185,144,187,52,194,26,231,170,62,44,3,61,222,106,21,225,120,
+161,155,193,159,127,145,160,235,140,156,159,243,56,178,86,136,195,87,208,61,199,159,77,60,121,54,192,18,252,184,94,65,174,149,220,114,205,114,228,176,82,178,28,99,48,242,112,48,80,250,154,169,27,23,
+221,121,163,29,76,78,105,58,176,24,134,43,235,13,28,172,30,79,97,178,26,206,132,37,180,90,81,112,22,187,194,186,35,232,2,130,11,116,120,201,82,184,93,216,181,177,28,247,166,53,34,63,52,131,96,179,4,
+141,67,172,33,37,31,145,48,27,174,74,9,147,115,16,11,55,188,152,54,203,62,30,171,137,158,146,2,31,60,198,212,194,18,29,40,128,213,218,75,165,49,78,252,180,156,90,42,211,137,15,133,146,69,176,245,86,
+83,176,105,49,235,181,180,17,223,180,89,2,147,15,200,235,150,8,228,204,184,10,248,177,145,191,108,226,125,188,67,247,83,228,50,250,125,156,175,122,54,125,3,7,116,66,61,205,159,101,39,232,159,63,31,
+208,63,127,126,130,1,46,1,200,208,102,199,88,82,124,28,101,31,115,234,97,176,98,139,31,116,121,241,153,234,15,159,65,72,124,225,78,63,91,138,225,211,90,96,33,96,180,254,172,66,167,147,194,101,238,136,
+137,39,111,11,71,152,155,6,223,239,174,247,28,166,145,206,112,175,237,84,110,219,3,174,106,232,123,96,234,132,200,138,66,69,224,3,40,55,57,142,47,48,96,67,191,144,34,8,195,222,107,71,248,29,248,8,95,
+28,32,243,43,41,75,32,178,205,152,107,104,22,6,70,19,102,159,81,41,190,146,2,8,129,79,8,93,195,172,63,104,209,13,206,199,221,0,85,124,15,45,71,89,48,142,59,247,137,225,227,120,224,236,131,25,202,132,
+219,75,218,200,143,220,220,61,23,102,196,64,126,58,29,98,99,124,74,1,255,127,248,141,129,60,1,189,162,185,246,19,113,26,255,126,217,76,164,238,247,196,111,220,70,27,183,16,220,56,37,38,228,201,179,
+233,137,145,90,185,8,122,37,122,93,56,54,227,136,9,235,214,132,65,97,224,108,125,236,53,64,251,3,237,172,254,189,51,30,238,235,154,121,46,4,179,178,28,102,61,166,134,229,61,86,117,61,159,188,151,142,
+184,227,187,206,207,219,207,2,199,33,3,51,77,111,144,134,115,123,151,148,65,234,73,113,109,139,232,69,200,243,121,228,230,150,163,191,30,189,3,70,226,222,48,72,141,66,247,98,180,117,107,93,87,52,55,3,
+8,204,43,55,215,191,220,255,4,115,164,167,197,40,1,38,216,255,5,32,204,240,58,229,201,114,90,47,185,124,13,213,60,4,140,31,192,117,114,231,39,108,9,247,115,168,133,230,134,62,24,212,185,168,106,227,
+177,112,111,159,40,237,67,100,16,230,182,185,241,99,186,191,241,235,246,126,95,41,185,96,221,219,125,108,152,37,8,87,250,222,91,212,53,238,244,31,164,44,49,152,187,47,89,110,20,21,26,33,25,239,254,
+246,7,106,153,38,228,188,121,116,250,29,190,39,213,195,132,116,23,111,221,98,150,140,220,149,66,180,94,59,123,175,189,242,157,123,152,160,139,178,127,35,237,234,180,228,186,42,233,30,47,242,142,16,
+106,35,89,148,178,184,75,160,36,18,1,35,119,231,133,26,139,97,68,96,71,159,207,191,22,89,21,187,9,13,119,126,205,198,165,125,209,251,215,64,96,47,127,154,199,223,217,217,33,195,127,255,2,80,75,1,2,20,
+3,20,0,0,0,8,0,0,0,129,76,226,242,38,131,44,1,0,0,8,3,0,0,10,0,0,0,0,0,0,0,0,0,0,0,128,1,0,0,0,0,105,110,100,101,120,46,104,116,109,108,80,75,1,2,20,3,20,0,0,0,8,0,0,0,129,76,34,150,136,212,133,1,0,0,
+128,3,0,0,6,0,0,0,0,0,0,0,0,0,0,0,128,1,84,1,0,0,117,105,46,99,115,115,80,75,1,2,20,3,20,0,0,0,8,0,0,0,129,76,220,159,106,242,133,8,0,0,92,27,0,0,5,0,0,0,0,0,0,0,0,0,0,0,128,1,253,2,0,0,117,105,46,
+106,115,80,75,5,6,0,0,0,0,3,0,3,0,159,0,0,0,165,11,0,0,0,0,0,0};
+
+const char* ui_zip = (const char*) temp_binary_data_0;
+
+
+const char* getNamedResource (const char*, int&) throw();
+const char* getNamedResource (const char* resourceNameUTF8, int& numBytes) throw()
+{
+    unsigned int hash = 0;
+    if (resourceNameUTF8 != 0)
+        while (*resourceNameUTF8 != 0)
+            hash = 31 * hash + (unsigned int) *resourceNameUTF8++;
+
+    switch (hash)
+    {
+        case 0xcd9baaf6:  numBytes = 3162; return ui_zip;
+        default: break;
+    }
+
+    numBytes = 0;
+    return 0;
+}
+
+const char* namedResourceList[] =
+{
+    "ui_zip"
+};
+
+}
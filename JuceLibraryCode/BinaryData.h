@@ -0,0 +1,23 @@
+/* =========================================================================================
+
+   This is an auto-generated file: Any edits you make may be overwritten!
+
+*/
+
+#pragma once
+
+namespace BinaryData
+{
+    extern const char*   ui_zip;
+    const int            ui_zipSize = 3162;
+
+    // Number of elements in the namedResourceList array.
+    const int namedResourceListSize = 1;
+
+    // Points to the start of a list of resource names.
+    extern const char* namedResourceList[];
+
+    // If you provide the name of one of the binary resource variables above, this function will
+    // return the corresponding data and its size (or a null pointer if the name isn't found).
+    const char* getNamedResource (const char* resourceNameUTF8, int& dataSizeInBytes) throw();
+}
@@ -29,6 +29,8 @@
 #include <juce_opengl/juce_opengl.h>
 #include <juce_video/juce_video.h>
 
+#include "BinaryData.h"
+
 #define DONT_SET_USING_JUCE_NAMESPACE 1
 #if ! DONT_SET_USING_JUCE_NAMESPACE
  // If your code uses a lot of JUCE classes, then this will obviously save you
@@ -0,0 +1,179 @@
+// Knobs bound to window.parameters, which the plugin injects into every page.
+(function () {
+    var knobs = [];
+
+    function drawKnob(knob) {
+        var canvas = knob.canvas;
+        var ctx = canvas.getContext("2d");
+        var value = window.parameters ? window.parameters[knob.param] : 0;
+        if (value === knob.drawnValue && canvas.width === knob.drawnWidth && canvas.height === knob.drawnHeight) {
+            return;
+        }
+        knob.drawnValue = value;
+        knob.drawnWidth = canvas.width;
+        knob.drawnHeight = canvas.height;
+
+        var start = 0.75 * Math.PI;
+        var end = start + 1.5 * Math.PI * value;
+        var r = canvas.width / 2 - 8;
+
+        ctx.clearRect(0, 0, canvas.width, canvas.height);
+        ctx.lineWidth = 6;
+        ctx.lineCap = "round";
+        ctx.strokeStyle = "#3a3c42";
+        ctx.beginPath();
+        ctx.arc(canvas.width / 2, canvas.height / 2, r, start, start + 1.5 * Math.PI);
+        ctx.stroke();
+        ctx.strokeStyle = "#e0a030";
+        ctx.beginPath();
+        ctx.arc(canvas.width / 2, canvas.height / 2, r, start, end);
+        ctx.stroke();
+    }
+
+    // The host automates parameters without telling the page, so values are
+    // checked every frame. Only a knob that changed is drawn, an unchanged
+    // page paints nothing and the plugin can tell it is idle.
+    function drawAll() {
+        knobs.forEach(drawKnob);
+        window.requestAnimationFrame(drawAll);
+    }
+
+    document.querySelectorAll(".knob").forEach(function (element) {
+        var knob = { param: element.dataset.param, canvas: element.querySelector("canvas") };
+        knobs.push(knob);
+
+        element.addEventListener("mousedown", function (down) {
+            var startY = down.clientY;
+            var startValue = window.parameters[knob.param];
+
+            function move(e) {
+                var value = Math.min(1, Math.max(0, startValue + (startY - e.clientY) / 200));
+                window.parameters[knob.param] = value;
+            }
+            function up() {
+                window.removeEventListener("mousemove", move);
+                window.removeEventListener("mouseup", up);
+            }
+            window.addEventListener("mousemove", move);
+            window.addEventListener("mouseup", up);
+        });
+    });
+
+    // Regions the plugin draws natively. Only their layout goes through the
+    // page, which leaves them empty and doesn't repaint while they animate.
+    var widgets = document.querySelectorAll(".native-widget");
+    var declared = "";
+    function declareWidgets() {
+        if (!window.setNativeWidgets) {
+            return;
+        }
+        var list = [];
+        widgets.forEach(function (element) {
+            var rect = element.getBoundingClientRect();
+            list.push({ id: element.id, kind: element.dataset.kind,
+                        x: rect.left, y: rect.top, width: rect.width, height: rect.height });
+        });
+        var json = JSON.stringify(list);
+        if (json !== declared) {
+            declared = json;
+            window.setNativeWidgets(list);
+        }
+    }
+    if (window.ResizeObserver) {
+        var observer = new ResizeObserver(declareWidgets);
+        observer.observe(document.body);
+        widgets.forEach(function (element) { observer.observe(element); });
+    }
+    window.addEventListener("resize", declareWidgets);
+    window.addEventListener("scroll", declareWidgets);
+    declareWidgets();
+
+    // The plugin measures the binary channel with payloads the page sends back.
+    if (window.binaryChannel) {
+        window.binaryChannel.onmessage = function (topic, buffer) {
+            if (topic === "echo") {
+                window.binaryChannel.send("echo", buffer);
+            }
+        };
+    }
+
+    // Measures nativeRpc: calls per second with all of them issued at once,
+    // then the round trip of one call at a time. The plugin logs the result.
+    window.runRpcBenchmark = function (numCalls) {
+        var rpc = window.nativeRpc;
+        var numSequential = 200;
+        var start = performance.now();
+        var calls = [];
+        for (var i = 0; i < numCalls; ++i) {
+            calls.push(rpc.call("echo", i));
+        }
+        return Promise.all(calls).then(function () {
+            var callsPerSecond = numCalls / ((performance.now() - start) / 1000);
+            var latencies = [];
+            function percentile(fraction) {
+                return latencies[Math.min(latencies.length - 1, Math.floor(fraction * latencies.length))];
+            }
+            function next() {
+                if (latencies.length === numSequential) {
+                    latencies.sort(function (a, b) { return a - b; });
+                    return rpc.call("reportRpcBenchmark", {
+                        calls: numCalls,
+                        callsPerSecond: callsPerSecond,
+                        p50Ms: percentile(0.5),
+                        p99Ms: percentile(0.99),
+                        maxMs: latencies[latencies.length - 1]
+                    });
+                }
+                var sentAt = performance.now();
+                return rpc.call("echo", 0).then(function () {
+                    latencies.push(performance.now() - sentAt);
+                    return next();
+                });
+            }
+            return next();
+        });
+    };
+
+    // The view the plugin saves with the session, opaque to it. Restored on
+    // load and whenever a pooled page is attached to an instance again.
+    if (window.nativeRpc) {
+        var saveTimer = 0;
+        window.addEventListener("scroll", function () {
+            clearTimeout(saveTimer);
+            saveTimer = setTimeout(function () {
+                window.nativeRpc.call("setUiState", JSON.stringify({ scrollX: window.scrollX, scrollY: window.scrollY }));
+            }, 250);
+        });
+        var restoreUiState = function () {
+            window.nativeRpc.call("getUiState").then(function (json) {
+                var state = json ? JSON.parse(json) : null;
+                if (state) {
+                    window.scrollTo(state.scrollX, state.scrollY);
+                }
+            }).catch(function () {});
+        };
+        window.onPluginAttached = restoreUiState;
+        restoreUiState();
+    }
+
+    window.onPluginMetrics = function (metrics) {
+        document.getElementById("metrics").textContent = JSON.stringify(metrics.audioLoad);
+    };
+
+    // Follows the pointer while the plugin measures input latency, so every
+    // input it sends repaints.
+    var probe = document.getElementById("probe");
+    function moveProbe(e) {
+        probe.style.transform = "translate(" + e.clientX + "px, " + e.clientY + "px)";
+    }
+    window.onPluginLatencyProbe = function (enabled) {
+        probe.style.display = enabled ? "block" : "none";
+        if (enabled) {
+            window.addEventListener("mousemove", moveProbe);
+        } else {
+            window.removeEventListener("mousemove", moveProbe);
+        }
+    };
+
+    drawAll();
+})();
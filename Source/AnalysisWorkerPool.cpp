@@ -0,0 +1,263 @@
+#include "AnalysisWorkerPool.h"
+
+class AnalysisWorkerPool::Worker
+    : public juce::Thread
+{
+public:
+    Worker(AnalysisWorkerPool& inPool, int index)
+        : juce::Thread("Analysis worker " + juce::String(index))
+        , mPool(inPool)
+    {
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            if (!mPool.runNextJob())
+            {
+                mPool.mJobAvailable.wait(100);
+            }
+        }
+    }
+
+private:
+    AnalysisWorkerPool& mPool;
+};
+
+// ----------------------------------------------------------------------------
+
+AnalysisWorkerPool::Client::Client()
+    : mNumRunning(0)
+{
+    mPool->addClient(this);
+}
+
+AnalysisWorkerPool::Client::~Client()
+{
+    cancelAll();
+    mPool->removeClient(this);
+}
+
+void AnalysisWorkerPool::Client::submit(Job job)
+{
+    mPool->enqueue(this, std::move(job));
+}
+
+void AnalysisWorkerPool::Client::cancelAll()
+{
+    mPool->cancel(this);
+}
+
+void AnalysisWorkerPool::Client::setFocused(bool inFocused)
+{
+    mPool->setFocusedClient(this, inFocused);
+}
+
+int AnalysisWorkerPool::Client::getNumPending() const
+{
+    const juce::ScopedLock sl(mPool->mLock);
+    return (int)mQueue.size() + mNumRunning;
+}
+
+// ----------------------------------------------------------------------------
+
+AnalysisWorkerPool::AnalysisWorkerPool()
+    : mFocusedClient(nullptr)
+    , mNextClient(0)
+    , mJobAvailable(false)
+    , mCreatedAt(juce::Time::getMillisecondCounterHiRes())
+    , mBusyMs(0)
+    , mLatencySumMs(0)
+    , mLatencyMaxMs(0)
+    , mNumJobsStarted(0)
+    , mNumJobsCancelled(0)
+{
+    // leave a core to the audio and message threads
+    const int numWorkers = juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1);
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        Worker* worker = mWorkers.add(new Worker(*this, i));
+        worker->startThread(4);
+    }
+}
+
+AnalysisWorkerPool::~AnalysisWorkerPool()
+{
+    // every Client holds a reference, so no job can be queued anymore
+    jassert(mClients.isEmpty());
+
+    for (Worker* worker : mWorkers)
+    {
+        worker->signalThreadShouldExit();
+    }
+    mJobAvailable.signal();
+    for (Worker* worker : mWorkers)
+    {
+        worker->stopThread(1000);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void AnalysisWorkerPool::addClient(Client* client)
+{
+    const juce::ScopedLock sl(mLock);
+    mClients.add(client);
+}
+
+void AnalysisWorkerPool::removeClient(Client* client)
+{
+    const juce::ScopedLock sl(mLock);
+    if (mFocusedClient == client)
+    {
+        mFocusedClient = nullptr;
+    }
+    mClients.removeFirstMatchingValue(client);
+}
+
+void AnalysisWorkerPool::setFocusedClient(Client* client, bool focused)
+{
+    const juce::ScopedLock sl(mLock);
+    if (focused)
+    {
+        mFocusedClient = client;
+    }
+    else if (mFocusedClient == client)
+    {
+        mFocusedClient = nullptr;
+    }
+}
+
+void AnalysisWorkerPool::enqueue(Client* client, Job job)
+{
+    {
+        const juce::ScopedLock sl(mLock);
+        Client::PendingJob pending;
+        pending.job = std::move(job);
+        pending.enqueueTime = juce::Time::getMillisecondCounterHiRes();
+        client->mQueue.push_back(std::move(pending));
+    }
+    mJobAvailable.signal();
+}
+
+void AnalysisWorkerPool::cancel(Client* client)
+{
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(mLock);
+            mNumJobsCancelled += (juce::int64)client->mQueue.size();
+            client->mQueue.clear();
+            if (client->mNumRunning == 0)
+            {
+                return;
+            }
+        }
+        client->mJobFinished.wait(10);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+AnalysisWorkerPool::Client* AnalysisWorkerPool::pickClient()
+{
+    if (mFocusedClient != nullptr && !mFocusedClient->mQueue.empty())
+    {
+        return mFocusedClient;
+    }
+
+    const int numClients = mClients.size();
+    for (int i = 0; i < numClients; ++i)
+    {
+        const int index = (mNextClient + i) % numClients;
+        Client* client = mClients.getUnchecked(index);
+        if (!client->mQueue.empty())
+        {
+            mNextClient = index + 1;
+            return client;
+        }
+    }
+    return nullptr;
+}
+
+bool AnalysisWorkerPool::runNextJob()
+{
+    Client* client;
+    Client::PendingJob pending;
+    {
+        const juce::ScopedLock sl(mLock);
+        client = pickClient();
+        if (client == nullptr)
+        {
+            return false;
+        }
+        pending = std::move(client->mQueue.front());
+        client->mQueue.pop_front();
+        ++client->mNumRunning;
+
+        // wake another worker if there is still work around
+        for (Client* other : mClients)
+        {
+            if (!other->mQueue.empty())
+            {
+                mJobAvailable.signal();
+                break;
+            }
+        }
+    }
+
+    const double start = juce::Time::getMillisecondCounterHiRes();
+    pending.job();
+    const double end = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        const juce::ScopedLock sl(mLock);
+        --client->mNumRunning;
+
+        const double latency = start - pending.enqueueTime;
+        mLatencySumMs += latency;
+        mLatencyMaxMs = std::max(mLatencyMaxMs, latency);
+        mBusyMs += end - start;
+        ++mNumJobsStarted;
+
+        // still under the lock, the client may go away as soon as it is released
+        client->mJobFinished.signal();
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+juce::var AnalysisWorkerPool::getMetrics(MetricsSnapshot& ioLast) const
+{
+    const juce::ScopedLock sl(mLock);
+
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double elapsed = std::max(1.0, now - (ioLast.time > 0.0 ? ioLast.time : mCreatedAt));
+    const juce::int64 numJobs = mNumJobsStarted - ioLast.numJobsStarted;
+
+    int queued = 0;
+    for (Client* client : mClients)
+    {
+        queued += (int)client->mQueue.size();
+    }
+
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("workers", mWorkers.size());
+    metrics->setProperty("clients", mClients.size());
+    metrics->setProperty("queued", queued);
+    metrics->setProperty("jobs", numJobs);
+    metrics->setProperty("cancelled", mNumJobsCancelled - ioLast.numJobsCancelled);
+    metrics->setProperty("utilisation", (mBusyMs - ioLast.busyMs) / (elapsed * mWorkers.size()));
+    metrics->setProperty("latencyAvgMs", numJobs > 0 ? (mLatencySumMs - ioLast.latencySumMs) / (double)numJobs : 0.0);
+    metrics->setProperty("latencyMaxMs", mLatencyMaxMs);
+
+    ioLast.time = now;
+    ioLast.busyMs = mBusyMs;
+    ioLast.latencySumMs = mLatencySumMs;
+    ioLast.numJobsStarted = mNumJobsStarted;
+    ioLast.numJobsCancelled = mNumJobsCancelled;
+
+    return juce::var(metrics);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Process-wide pool of worker threads shared by every plugin instance for
+    UI-side analysis jobs. Today the only one is folding the waveform
+    envelopes, see GLProcessorEditor::timerCallback().
+
+    Instances never talk to the pool directly, they own a Client which keeps
+    their own job queue. Idle workers pick the next job round-robin across
+    clients so a busy instance cannot starve the others, jobs of the focused
+    client are always taken first, and destroying a Client cancels its queued
+    jobs and waits for the running ones.
+*/
+class AnalysisWorkerPool
+{
+public:
+    typedef std::function<void()> Job;
+
+    class Client
+    {
+    public:
+        Client();
+        ~Client();
+
+        void submit(Job job);
+
+        // Drops the queued jobs and waits for the running ones to finish.
+        void cancelAll();
+
+        void setFocused(bool inFocused);
+
+        int getNumPending() const;
+
+    private:
+        friend class AnalysisWorkerPool;
+
+        struct PendingJob
+        {
+            Job     job;
+            double  enqueueTime;
+        };
+
+        juce::SharedResourcePointer<AnalysisWorkerPool> mPool;
+        std::deque<PendingJob>  mQueue;         // guarded by the pool lock
+        int                     mNumRunning;    // guarded by the pool lock
+        juce::WaitableEvent     mJobFinished;
+
+        JUCE_DECLARE_NON_COPYABLE(Client)
+    };
+
+    /** The pool's cumulative counters as one reader saw them last. */
+    struct MetricsSnapshot
+    {
+        double          time = 0.0;
+        double          busyMs = 0.0;
+        double          latencySumMs = 0.0;
+        juce::int64     numJobsStarted = 0;
+        juce::int64     numJobsCancelled = 0;
+    };
+
+public:
+    AnalysisWorkerPool();
+    ~AnalysisWorkerPool();
+
+    int getNumWorkers() const { return mWorkers.size(); }
+
+    // Utilisation and queue latency since ioLast, which is then advanced.
+    // Every reader keeps its own, the pool is shared by all instances.
+    juce::var getMetrics(MetricsSnapshot& ioLast) const;
+
+private:
+    class Worker;
+
+    void addClient(Client* client);
+    void removeClient(Client* client);
+    void setFocusedClient(Client* client, bool focused);
+    void enqueue(Client* client, Job job);
+    void cancel(Client* client);
+
+    // Returns false when there was nothing to run.
+    bool runNextJob();
+    Client* pickClient();
+
+private:
+    mutable juce::CriticalSection mLock;
+    juce::Array<Client*>        mClients;
+    Client*                     mFocusedClient;
+    int                         mNextClient;
+    juce::WaitableEvent         mJobAvailable;
+    juce::OwnedArray<Worker>    mWorkers;
+
+    // cumulative metrics, guarded by mLock
+    const double                mCreatedAt;
+    double                      mBusyMs;
+    double                      mLatencySumMs;
+    double                      mLatencyMaxMs;     // over the pool's lifetime
+    juce::int64                 mNumJobsStarted;
+    juce::int64                 mNumJobsCancelled;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalysisWorkerPool)
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Fixed-bin histogram that can be fed from a real-time thread.
+
+    add() is wait-free and never allocates, readers on other threads compute
+    percentiles from the bins. Values past the last bin land in the last one,
+    getMax() still reports the exact worst case.
+*/
+class AtomicHistogram
+{
+public:
+    AtomicHistogram(double inBinWidth, int inNumBins)
+        : mBinWidth(inBinWidth)
+        , mNumBins(inNumBins)
+        , mBins(new std::atomic<juce::uint32>[inNumBins]())
+        , mCount(0)
+        , mSum(0)
+        , mMax(0)
+    {
+    }
+
+public:
+    void add(double value)
+    {
+        const int bin = juce::jlimit(0, mNumBins - 1, (int)(value / mBinWidth));
+        mBins[bin].fetch_add(1, std::memory_order_relaxed);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+
+        double sum = mSum.load(std::memory_order_relaxed);
+        while (!mSum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+        {
+        }
+
+        double max = mMax.load(std::memory_order_relaxed);
+        while (value > max && !mMax.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void reset()
+    {
+        for (int i = 0; i < mNumBins; ++i)
+        {
+            mBins[i].store(0, std::memory_order_relaxed);
+        }
+        mCount = 0;
+        mSum = 0;
+        mMax = 0;
+    }
+
+public:
+    juce::int64 getCount() const
+    {
+        return mCount.load(std::memory_order_relaxed);
+    }
+
+    double getMean() const
+    {
+        const juce::int64 count = getCount();
+        return count > 0 ? mSum.load(std::memory_order_relaxed) / (double)count : 0.0;
+    }
+
+    double getMax() const
+    {
+        return mMax.load(std::memory_order_relaxed);
+    }
+
+    // Upper edge of the bin holding the given fraction (0..1) of the values.
+    double getPercentile(double fraction) const
+    {
+        juce::int64 total = 0;
+        for (int i = 0; i < mNumBins; ++i)
+        {
+            total += mBins[i].load(std::memory_order_relaxed);
+        }
+        if (total == 0)
+        {
+            return 0.0;
+        }
+
+        const juce::int64 target = (juce::int64)std::ceil(fraction * (double)total);
+        juce::int64 seen = 0;
+        for (int i = 0; i < mNumBins; ++i)
+        {
+            seen += mBins[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+            {
+                return std::min((i + 1) * mBinWidth, getMax());
+            }
+        }
+        return getMax();
+    }
+
+private:
+    const double                                    mBinWidth;
+    const int                                       mNumBins;
+    std::unique_ptr<std::atomic<juce::uint32>[]>    mBins;
+    std::atomic<juce::int64>                        mCount;
+    std::atomic<double>                             mSum;
+    std::atomic<double>                             mMax;
+
+    JUCE_DECLARE_NON_COPYABLE(AtomicHistogram)
+};
@@ -0,0 +1,203 @@
+#include "BinaryChannel.h"
+#include <atomic>
+#include <iterator>
+
+const char* BinaryChannel::sMessage = "binary";
+
+namespace
+{
+    // Holds a buffer until V8 collects the ArrayBuffer over it.
+    class BufferRelease
+        : public CefV8ArrayBufferReleaseCallback
+    {
+    public:
+        explicit BufferRelease(BinaryChannel::Buffer* inBuffer)
+            : mBuffer(inBuffer)
+        {
+        }
+
+        void ReleaseBuffer(void* buffer) override
+        {
+            mBuffer = nullptr;
+        }
+
+    private:
+        BinaryChannel::Buffer::Ptr mBuffer;
+
+        IMPLEMENT_REFCOUNTING(BufferRelease);
+    };
+
+    double getMBps(size_t bytes, double ms)
+    {
+        return ms > 0.0 ? (double)bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+    }
+}
+
+bool BinaryChannel::send(CefRefPtr<CefBrowser> browser, CefProcessId target,
+                         const juce::String& topic, const void* data, size_t size)
+{
+    if (browser == nullptr || size > kMaxTransferSize)
+    {
+        return false;
+    }
+
+    static std::atomic<int> sNextTransferId(1);
+    const int transferId = sNextTransferId++;
+    const int numChunks = juce::jmax(1, (int)((size + kChunkSize - 1) / kChunkSize));
+    const double sentAt = juce::Time::getMillisecondCounterHiRes();
+    const std::string topicString = topic.toStdString();
+
+    for (int i = 0; i < numChunks; ++i)
+    {
+        const size_t offset = (size_t)i * kChunkSize;
+        const size_t chunkSize = juce::jmin((size_t)kChunkSize, size - offset);
+
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(sMessage);
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        args->SetString(0, topicString);
+        args->SetInt(1, transferId);
+        args->SetInt(2, i);
+        args->SetInt(3, numChunks);
+        args->SetInt(4, (int)size);
+        args->SetDouble(5, sentAt);
+        args->SetBinary(6, CefBinaryValue::Create(static_cast<const char*>(data) + offset, chunkSize));
+        if (!browser->SendProcessMessage(target, message))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+CefRefPtr<CefV8Value> BinaryChannel::Buffer::createArrayBuffer()
+{
+    // V8 wants a non-null pointer, even for nothing
+    if (data.getSize() == 0)
+    {
+        data.setSize(1);
+        return CefV8Value::CreateArrayBuffer(data.getData(), 0, new BufferRelease(this));
+    }
+    return CefV8Value::CreateArrayBuffer(data.getData(), data.getSize(), new BufferRelease(this));
+}
+
+// ----------------------------------------------------------------------------
+
+bool BinaryChannel::Assembler::add(CefRefPtr<CefListValue> args, juce::String& outTopic, juce::MemoryBlock& outData, double& outMs)
+{
+    if (args->GetSize() < 7 || args->GetType(6) != VTYPE_BINARY)
+    {
+        return false;
+    }
+
+    const int transferId = args->GetInt(1);
+    const int chunk = args->GetInt(2);
+    const int numChunks = args->GetInt(3);
+    const int size = args->GetInt(4);
+    CefRefPtr<CefBinaryValue> bytes = args->GetBinary(6);
+    const double now = juce::Time::getMillisecondCounterHiRes();
+
+    for (TransferMap::iterator it = mTransfers.begin(); it != mTransfers.end();)
+    {
+        it = now - it->second.lastChunkAt > kTransferTimeoutMs ? remove(it) : std::next(it);
+    }
+
+    if (chunk == 0)
+    {
+        // a sender starting over on a topic gave up on what it sent before
+        const juce::String topic(args->GetString(0).ToString());
+        for (TransferMap::iterator it = mTransfers.begin(); it != mTransfers.end();)
+        {
+            it = it->first == transferId || it->second.topic == topic ? remove(it) : std::next(it);
+        }
+
+        // the page's word, send() never announces more
+        const int expectedChunks = juce::jmax(1, (int)(((size_t)juce::jmax(0, size) + kChunkSize - 1) / kChunkSize));
+        if (size < 0 || size > kMaxTransferSize || numChunks != expectedChunks
+            || mPendingBytes + (size_t)size > (size_t)kMaxTransferSize)
+        {
+            return false;
+        }
+
+        Transfer& transfer = mTransfers[transferId];
+        transfer.topic = topic;
+        transfer.size = (size_t)size;
+        transfer.numChunks = numChunks;
+        transfer.data.setSize(transfer.size);
+        transfer.sentAt = args->GetDouble(5);
+        mPendingBytes += transfer.size;
+    }
+
+    TransferMap::iterator found = mTransfers.find(transferId);
+    if (found == mTransfers.end())
+    {
+        return false;
+    }
+
+    Transfer& transfer = found->second;
+    const size_t chunkSize = bytes->GetSize();
+    if (chunk != transfer.nextChunk || numChunks != transfer.numChunks || transfer.received + chunkSize > transfer.size)
+    {
+        remove(found);
+        return false;
+    }
+
+    bytes->GetData(static_cast<char*>(transfer.data.getData()) + transfer.received, chunkSize, 0);
+    transfer.received += chunkSize;
+    transfer.lastChunkAt = now;
+    if (++transfer.nextChunk < transfer.numChunks)
+    {
+        return false;
+    }
+    if (transfer.received != transfer.size)
+    {
+        remove(found);
+        return false;
+    }
+
+    outTopic = transfer.topic;
+    outData.swapWith(transfer.data);
+    outMs = now - transfer.sentAt;
+    remove(found);
+    return true;
+}
+
+BinaryChannel::Assembler::TransferMap::iterator BinaryChannel::Assembler::remove(TransferMap::iterator transfer)
+{
+    mPendingBytes -= transfer->second.size;
+    return mTransfers.erase(transfer);
+}
+
+// ----------------------------------------------------------------------------
+
+void BinaryChannel::Stats::addSent(size_t bytes)
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    mBytesSent += (juce::int64)bytes;
+    mChunksSent += juce::jmax((juce::int64)1, ((juce::int64)bytes + kChunkSize - 1) / kChunkSize);
+    ++mTransfersSent;
+}
+
+void BinaryChannel::Stats::addReceived(size_t bytes, double ms)
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    mBytesReceived += (juce::int64)bytes;
+    ++mTransfersReceived;
+    mReceiveMs += ms;
+    mLastReceiveMBps = getMBps(bytes, ms);
+}
+
+juce::var BinaryChannel::Stats::getMetrics() const
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("bytesSent", mBytesSent);
+    metrics->setProperty("transfersSent", mTransfersSent);
+    metrics->setProperty("chunksSent", mChunksSent);
+    metrics->setProperty("bytesReceived", mBytesReceived);
+    metrics->setProperty("transfersReceived", mTransfersReceived);
+    metrics->setProperty("receiveMBps", getMBps((size_t)mBytesReceived, mReceiveMs));
+    metrics->setProperty("lastReceiveMBps", mLastReceiveMBps);
+    return juce::var(metrics);
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <map>
+#include <include/cef_browser.h>
+#include <include/cef_process_message.h>
+#include <include/cef_v8.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Bulk binary transfers between native code and the page, such as spectra,
+    waveforms or preset blobs, without JSON or a V8 call per element.
+
+    A payload is split into CefBinaryValue chunks of at most kChunkSize bytes,
+    one sMessage process message each, and reassembled on the other side. Both
+    directions use the same format, in one process as with the browser helper.
+
+    In the page:
+        window.binaryChannel.send(topic, typedArrayOrArrayBuffer);
+        window.binaryChannel.onmessage = function (topic, arrayBuffer, info) {};
+    info holds the transfer's bytes and ms, from the first chunk sent to the
+    last one received. The page copies what it sends with one set() into an
+    ArrayBuffer over renderer memory, and receives an ArrayBuffer over the
+    reassembled bytes themselves.
+*/
+class BinaryChannel
+{
+public:
+    // arguments are topic, transfer id, chunk index, chunk count, total size,
+    // send time in ms and the chunk's bytes
+    static const char* sMessage;
+
+    enum
+    {
+        kChunkSize = 256 * 1024,
+        kMaxTransferSize = 256 * 1024 * 1024,
+        kTransferTimeoutMs = 10000      // a partial transfer without chunks for this long is dropped
+    };
+
+    // Any thread. False if the payload is too large or there is no browser.
+    static bool send(CefRefPtr<CefBrowser> browser, CefProcessId target,
+                     const juce::String& topic, const void* data, size_t size);
+
+    /** Bytes V8 sees as an ArrayBuffer, alive until V8 lets go of it. */
+    class Buffer
+        : public juce::ReferenceCountedObject
+    {
+    public:
+        typedef juce::ReferenceCountedObjectPtr<Buffer> Ptr;
+
+        juce::MemoryBlock data;
+
+        // With a V8 context entered.
+        CefRefPtr<CefV8Value> createArrayBuffer();
+    };
+
+    /**
+        Reassembles the transfers of one sender, whose chunks arrive in order.
+
+        The sizes a sender announces are checked against kMaxTransferSize, for
+        every partial transfer together. A partial transfer is dropped when a
+        new one starts on its topic, or kTransferTimeoutMs after its last chunk,
+        so a sender that gives up midway leaves nothing behind.
+    */
+    class Assembler
+    {
+    public:
+        // True once the last chunk of a transfer arrived, the out arguments
+        // then hold it. Drops transfers whose chunks went missing.
+        bool add(CefRefPtr<CefListValue> args, juce::String& outTopic, juce::MemoryBlock& outData, double& outMs);
+
+    private:
+        struct Transfer
+        {
+            juce::String        topic;
+            juce::MemoryBlock   data;
+            size_t              size = 0;
+            size_t              received = 0;
+            int                 numChunks = 0;
+            int                 nextChunk = 0;
+            double              sentAt = 0.0;
+            double              lastChunkAt = 0.0;
+        };
+
+        typedef std::map<int, Transfer> TransferMap;
+
+        TransferMap::iterator remove(TransferMap::iterator transfer);
+
+        TransferMap             mTransfers;
+        size_t                  mPendingBytes = 0;
+    };
+
+    /** Counters and throughput of one end of the channel, any thread. */
+    class Stats
+    {
+    public:
+        void addSent(size_t bytes);
+        void addReceived(size_t bytes, double ms);
+        juce::var getMetrics() const;
+
+    private:
+        juce::int64             mBytesSent = 0;
+        juce::int64             mTransfersSent = 0;
+        juce::int64             mChunksSent = 0;
+        juce::int64             mBytesReceived = 0;
+        juce::int64             mTransfersReceived = 0;
+        double                  mReceiveMs = 0.0;
+        double                  mLastReceiveMBps = 0.0;
+        mutable juce::SpinLock  mLock;
+    };
+};
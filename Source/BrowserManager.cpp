@@ -1,7 +1,296 @@
 #include "BrowserManager.h"
+#include "BrowserPool.h"
+#include "UiSchemeHandler.h"
+
+std::atomic<juce::int64> RenderHandler::sSnapshotBytes(0);
 
 //const char* BrowserManager::sTestUrl = "https://www.youtube.com/watch?v=kRKcHyVMfQA";
 //const char* BrowserManager::sTestUrl = "https://sourcemaking.com/design_patterns/singleton/cpp/1";
 //const char* BrowserManager::sTestUrl = "https://musiclab.chromeexperiments.com/";
 //const char* BrowserManager::sTestUrl = "https://www.awwwards.com/sites/murmure-studio";
-const char* BrowserManager::sTestUrl = "file:///D:/Development/Web/Projects/JsKnob/index.html";
+//const char* BrowserManager::sTestUrl = "file:///D:/Development/Web/Projects/JsKnob/index.html";
+const char* BrowserManager::sTestUrl = nullptr;
+
+juce::String BrowserManager::getStartUrl()
+{
+    // the bundled UI unless a test page is set above
+    return sTestUrl != nullptr ? juce::String(sTestUrl) : UiSchemeHandlerFactory::getEntryUrl();
+}
+
+static juce::var describeLatency(const AtomicHistogram& latency)
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("count", latency.getCount());
+    metrics->setProperty("meanMs", latency.getMean());
+    metrics->setProperty("p50Ms", latency.getPercentile(0.5));
+    metrics->setProperty("p95Ms", latency.getPercentile(0.95));
+    metrics->setProperty("p99Ms", latency.getPercentile(0.99));
+    metrics->setProperty("maxMs", latency.getMax());
+    return juce::var(metrics);
+}
+
+BrowserManager::BrowserManager(juce::AudioProcessor* inAudioProcessor)
+    : mAudioProcessor(inAudioProcessor)
+    , mSnapshotFrameLatency(5.0, 200)
+    , mLiveFrameLatency(5.0, 200)
+    , mInputToPaintLatency(1.0, 250)
+    , mInputToPresentLatency(1.0, 250)
+{
+    addRpcMethods();
+}
+
+BrowserManager::~BrowserManager()
+{
+    stopTimer();
+    stop();
+
+    if (mPool != nullptr)
+    {
+        (*mPool)->forgetOwner(mAudioProcessor);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void BrowserManager::start()
+{
+    joinPool();
+    if (mBrowser == nullptr)
+    {
+        mBrowser = (*mPool)->acquire(mAudioProcessor);
+        mBrowser->getBrowserClient()->setRpcServer(&mRpc);
+    }
+}
+
+void BrowserManager::warmUp()
+{
+    // a scan may prepare the plugin too, but lets it go before the timer fires,
+    // joinPool() does nothing once joined
+    if (!isTimerRunning())
+    {
+        startTimer(kWarmUpDelayMs);
+    }
+}
+
+void BrowserManager::stop()
+{
+    juce::Array<Layer> layers;
+    {
+        const juce::SpinLock::ScopedLockType sl(mLayerLock);
+        layers.swapWith(mLayers);
+    }
+    for (const Layer& layer : layers)
+    {
+        (*mPool)->releaseLayer(layer.browser);
+    }
+
+    if (mBrowser != nullptr)
+    {
+        mBrowser->getBrowserClient()->setRpcServer(nullptr);
+        mRpc.cancelAll();
+        (*mPool)->release(mBrowser);
+        mBrowser = nullptr;
+    }
+}
+
+std::shared_future<bool> BrowserManager::getReadiness() const
+{
+    jassert(mBrowser != nullptr);
+    return mBrowser->getReadiness();
+}
+
+CefRefPtr<RenderHandler> BrowserManager::getRenderHandler() const
+{
+    return mBrowser != nullptr ? mBrowser->getRenderHandler() : nullptr;
+}
+
+CefRefPtr<CefBrowser> BrowserManager::getBrowser() const
+{
+    return mBrowser != nullptr ? mBrowser->getBrowser() : nullptr;
+}
+
+int BrowserManager::addLayer(const juce::String& url, juce::Rectangle<int> bounds, int frameRate)
+{
+    jassert(mBrowser != nullptr);
+
+    Layer layer;
+    layer.browser = (*mPool)->createLayer(mAudioProcessor, url, bounds.getWidth(), bounds.getHeight(), frameRate);
+    layer.bounds = bounds;
+
+    const juce::SpinLock::ScopedLockType sl(mLayerLock);
+    mLayers.add(layer);
+    return mLayers.size() - 1;
+}
+
+int BrowserManager::getNumLayers() const
+{
+    const juce::SpinLock::ScopedLockType sl(mLayerLock);
+    return mLayers.size();
+}
+
+CefRefPtr<RenderHandler> BrowserManager::getLayerRenderHandler(int index) const
+{
+    const juce::SpinLock::ScopedLockType sl(mLayerLock);
+    return juce::isPositiveAndBelow(index, mLayers.size()) ? mLayers.getReference(index).browser->getRenderHandler() : nullptr;
+}
+
+juce::Rectangle<int> BrowserManager::getLayerBounds(int index) const
+{
+    const juce::SpinLock::ScopedLockType sl(mLayerLock);
+    return juce::isPositiveAndBelow(index, mLayers.size()) ? mLayers.getReference(index).bounds : juce::Rectangle<int>();
+}
+
+void BrowserManager::getNativeWidgets(juce::Array<NativeWidget>& outWidgets) const
+{
+    if (mBrowser != nullptr)
+    {
+        mBrowser->getNativeWidgets(outWidgets);
+    }
+    else
+    {
+        outWidgets.clearQuick();
+    }
+}
+
+bool BrowserManager::hasNativeWidgets() const
+{
+    return mBrowser != nullptr && mBrowser->hasNativeWidgets();
+}
+
+SharedCanvas::Ptr BrowserManager::getSharedCanvas() const
+{
+    return mBrowser != nullptr ? mBrowser->getSharedCanvas() : nullptr;
+}
+
+bool BrowserManager::sendBinary(const juce::String& topic, const void* data, size_t size)
+{
+    return mBrowser != nullptr && mBrowser->getBrowserClient()->sendBinary(topic, data, size);
+}
+
+void BrowserManager::setBinaryListener(std::function<void(const juce::String& topic, const juce::MemoryBlock& data)> listener)
+{
+    if (mBrowser != nullptr)
+    {
+        mBrowser->getBrowserClient()->setBinaryListener(listener);
+    }
+}
+
+juce::var BrowserManager::getBinaryChannelMetrics() const
+{
+    return mBrowser != nullptr ? mBrowser->getBrowserClient()->getBinaryMetrics() : juce::var();
+}
+
+void BrowserManager::syncParameters()
+{
+    if (mBrowser != nullptr)
+    {
+        mBrowser->syncParameters();
+    }
+
+    const juce::SpinLock::ScopedLockType sl(mLayerLock);
+    for (const Layer& layer : mLayers)
+    {
+        layer.browser->syncParameters();
+    }
+}
+
+juce::var BrowserManager::getPoolMetrics() const
+{
+    return mPool != nullptr ? (*mPool)->getMetrics() : juce::var();
+}
+
+juce::var BrowserManager::getMessagePumpMetrics()
+{
+    return mPool != nullptr ? (*mPool)->getRuntime().getMessagePumpMetrics(mMessagePumpMetrics) : juce::var();
+}
+
+juce::var BrowserManager::getEditorOpenMetrics() const
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("snapshotFrame", describeLatency(mSnapshotFrameLatency));
+    metrics->setProperty("liveFrame", describeLatency(mLiveFrameLatency));
+    if (mBrowser != nullptr)
+    {
+        metrics->setProperty("contextSetup", describeLatency(mBrowser->getBrowserClient()->getContextSetupTimes()));
+    }
+    return juce::var(metrics);
+}
+
+void BrowserManager::addInputLatency(double paintMs, double presentMs)
+{
+    mInputToPaintLatency.add(paintMs);
+    mInputToPresentLatency.add(presentMs);
+}
+
+void BrowserManager::resetInputLatency()
+{
+    mInputToPaintLatency.reset();
+    mInputToPresentLatency.reset();
+}
+
+juce::var BrowserManager::getInputLatencyMetrics() const
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("paint", describeLatency(mInputToPaintLatency));
+    metrics->setProperty("present", describeLatency(mInputToPresentLatency));
+    return juce::var(metrics);
+}
+
+// ----------------------------------------------------------------------------
+
+void BrowserManager::timerCallback()
+{
+    stopTimer();
+    joinPool();
+}
+
+void BrowserManager::addRpcMethods()
+{
+    // run on the analysis pool, cancelled by stop()
+    mRpc.addMethod("echo", [](const juce::var& params, juce::var& outResult)
+    {
+        outResult = params;
+        return juce::Result::ok();
+    });
+
+    juce::AudioProcessor* processor = mAudioProcessor;
+    mRpc.addMethod("getParameters", [processor](const juce::var& params, juce::var& outResult)
+    {
+        juce::Array<juce::var> parameters;
+        for (const juce::AudioProcessorParameter* param : processor->getParameters())
+        {
+            juce::DynamicObject* parameter = new juce::DynamicObject();
+            parameter->setProperty("name", param->getName(256));
+            parameter->setProperty("value", param->getValue());
+            parameter->setProperty("text", param->getText(param->getValue(), 256));
+            parameters.add(juce::var(parameter));
+        }
+        outResult = parameters;
+        return juce::Result::ok();
+    });
+
+    // the page measures, see runRpcBenchmark() in ui.js
+    mRpc.addMethod("reportRpcBenchmark", [](const juce::var& params, juce::var& outResult)
+    {
+        const juce::File resultFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                          .getChildFile("CEFPlugIn")
+                                          .getChildFile("rpc-benchmark.json");
+        resultFile.getParentDirectory().createDirectory();
+        if (!resultFile.replaceWithText(juce::JSON::toString(params)))
+        {
+            return juce::Result::fail("could not write " + resultFile.getFullPathName());
+        }
+        CEFPLUGIN_LOG_INFO("rpc", "%d calls/s, round trip p50 %.3f ms p99 %.3f ms",
+                           (int)params["callsPerSecond"], (double)params["p50Ms"], (double)params["p99Ms"]);
+        return juce::Result::ok();
+    });
+}
+
+void BrowserManager::joinPool()
+{
+    if (mPool == nullptr)
+    {
+        // the first instance to get here starts CEF on its own thread
+        mPool = new juce::SharedResourcePointer<BrowserPool>();
+    }
+}
@@ -1,47 +1,169 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <include/cef_app.h>
 #include <include/cef_client.h>
+#include "AtomicHistogram.h"
+#include "CefRuntime.h"
+#include "NativeWidgets.h"
+#include "PluginLog.h"
+#include "RpcServer.h"
+#include "StartupTracer.h"
 #include "../JuceLibraryCode/JuceHeader.h"
 
 class RenderHandler
     : public CefRenderHandler
 {
 public:
+    enum
+    {
+        kMaxInputLatencyMs = 1000,  // input that painted nothing is forgotten after this
+        kInputTargetRadius = 16,    // view pixels around a hover a paint has to touch
+        kFrameRate = 30,            // CefBrowserSettings::windowless_frame_rate
+        kBusyIntervalMs = 100,      // paints closer than this are an animation
+        kMaxSnapshotPixels = 1280 * 800,    // stands in until the live frame comes, soft is fine
+        kSnapshotBudgetBytes = 24 << 20     // every snapshot in the process together
+    };
+
     RenderHandler(int w, int h)
         : mWidth(w)
         , mHeight(h)
-        , mBuffer(nullptr)
         , mOpenGLContext(nullptr)
+        , mBuffer(nullptr)
+        , mBufferWidth(0)
+        , mBufferHeight(0)
+        , mFrameCount(0)
+        , mPendingInputTime(0.0)
+        , mPendingInputAnywhere(false)
+        , mPaintedInputTime(0.0)
+        , mPaintedAt(0.0)
+        , mPaintedFrame(0)
+        , mRenderScale(1.0f)
+        , mBufferScale(1.0f)
+        , mLastPaintAt(0.0)
+        , mFrameTimeMs(0.0)
+        , mPopupVisible(false)
+        , mPopupWidth(0)
+        , mPopupHeight(0)
+        , mPopupFrameCount(0)
     {
         resize(w, h);
     }
 
     ~RenderHandler()
     {
-        mOpenGLContext->detach();
-        free(mBuffer);
+        if (mOpenGLContext != nullptr)
+        {
+            mOpenGLContext->detach();
+        }
+        delete[] mBuffer;
     }
 
     bool GetViewRect(CefRefPtr<CefBrowser> browser, CefRect &rect)
     {
-        //OutputDebugStringW(L"GetViewRect()\n");
         rect = CefRect(0, 0, mWidth, mHeight);
         return true;
     }
 
+    // The view keeps its size in CSS pixels, the render scale only shrinks
+    // the backing Chromium rasters into. Input stays in view coordinates.
+    bool GetScreenInfo(CefRefPtr<CefBrowser> browser, CefScreenInfo& screen_info) override
+    {
+        CefRect rect;
+        GetViewRect(browser, rect);
+        screen_info.device_scale_factor = mRenderScale;
+        screen_info.rect = rect;
+        screen_info.available_rect = rect;
+        return true;
+    }
+
+    // Select dropdowns and the like, painted into their own buffer and
+    // composited over the view.
+    void OnPopupShow(CefRefPtr<CefBrowser> browser, bool show) override
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        mPopupVisible = show;
+        if (!show)
+        {
+            mPopupRect = CefRect();
+            mPopupWidth = mPopupHeight = 0;
+        }
+    }
+
+    void OnPopupSize(CefRefPtr<CefBrowser> browser, const CefRect& rect) override
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        mPopupRect = rect;
+    }
+
     void OnPaint(CefRefPtr<CefBrowser> browser, PaintElementType type, const RectList &dirtyRects, const void * buffer, int w, int h)
     {
-        //OutputDebugStringW(L"OnPaint()\n");
-        //if (w != mWidth || h != mHeight)
-        //{
-        //    resize(w, h);
-        //}
+        // popups never answer input for the latency, they open on their own
+        if (type == PET_POPUP)
+        {
+            {
+                const juce::SpinLock::ScopedLockType sl(mBufferLock);
+                mPopupBuffer.malloc((size_t)w * (size_t)h);
+                memcpy(mPopupBuffer, buffer, ((size_t)w * (size_t)h) << 2);
+                mPopupWidth = w;
+                mPopupHeight = h;
+                ++mPopupFrameCount;
+            }
+            if (mOpenGLContext != nullptr)
+            {
+                mOpenGLContext->triggerRepaint();
+            }
+            return;
+        }
 
-        mBufferWidth = std::min(mWidth, w);
-        mBufferHeight = std::min(mHeight, h);
+        {
+            const juce::SpinLock::ScopedLockType sl(mBufferLock);
+            mBufferWidth = std::min(mWidth, w);
+            mBufferHeight = std::min(mHeight, h);
+            // frames rendered before a scale change may still arrive
+            mBufferScale = mWidth > 0 ? (float)w / (float)mWidth : 1.0f;
+
+            // a frame of the old size may still arrive after resize()
+            for (int y = 0; y < mBufferHeight; ++y)
+            {
+                memcpy(mBuffer + y * mBufferWidth, (const uint32*)buffer + y * w, mBufferWidth << 2);
+            }
+
+            const double now = juce::Time::getMillisecondCounterHiRes();
+            const double interval = now - mLastPaintAt;
+            if (interval < kBusyIntervalMs)
+            {
+                mFrameTimeMs = mFrameTimeMs > 0.0 ? 0.9 * mFrameTimeMs + 0.1 * interval : interval;
+            }
+            mLastPaintAt = now;
+        }
+        const juce::uint32 frameCount = mFrameCount.fetch_add(1) + 1;
+        if (frameCount == 1)
+        {
+            StartupTracer::addInstant("FirstOnPaint", browser->GetIdentifier());
+        }
 
-        memcpy(mBuffer, buffer, mBufferWidth * mBufferHeight << 2);
+        {
+            // the first paint that touches what the input targets is taken as
+            // its response, a caret blinking or an animation elsewhere is not
+            const juce::SpinLock::ScopedLockType sl(mInputLock);
+            const double now = juce::Time::getMillisecondCounterHiRes();
+            const float bufferScale = mWidth > 0 ? (float)w / (float)mWidth : 1.0f;
+            if (mPendingInputTime > 0.0 && now - mPendingInputTime > kMaxInputLatencyMs)
+            {
+                mPendingInputTime = 0.0;
+            }
+            else if (mPendingInputTime > 0.0 && (mPendingInputAnywhere || touchesInputTarget(dirtyRects, bufferScale)))
+            {
+                mPaintedInputTime = mPendingInputTime;
+                mPaintedAt = now;
+                mPaintedFrame = frameCount;
+                mPendingInputTime = 0.0;
+            }
+        }
         if (mOpenGLContext != nullptr)
         {
             mOpenGLContext->triggerRepaint();
@@ -50,11 +172,14 @@ public:
 
     void resize(int w, int h)
     {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
         mWidth = w;
         mHeight = h;
+        mBufferWidth = 0;
+        mBufferHeight = 0;
         if (mBuffer != nullptr)
         {
-            free(mBuffer);
+            delete[] mBuffer;
         }
         mBuffer = new uint32[w * h];
     }
@@ -68,45 +193,258 @@ public:
     {
         mOpenGLContext = inOpenGLContext;
     }
-    uint32* getBuffer(int& outWidth, int& outHeight)
+    // Hands the last frame to the given function as BGRA rows, top down,
+    // with the render scale it was painted at.
+    template <typename ReadFunction>
+    void readFrame(ReadFunction&& read) const
     {
-        outWidth = mBufferWidth;
-        outHeight = mBufferHeight;
-        return mBuffer;
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        read(mBuffer, mBufferWidth, mBufferHeight, mBufferScale);
     }
 
-private:
-    int mWidth;
-    int mHeight;
+    // Like readFrame(), with the popup's frame number and bounds in view
+    // pixels. Returns false while no popup is shown.
+    template <typename ReadFunction>
+    bool readPopup(ReadFunction&& read) const
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        if (!mPopupVisible || mPopupWidth <= 0 || mPopupHeight <= 0)
+        {
+            return false;
+        }
+        const juce::Rectangle<int> bounds(mPopupRect.x, mPopupRect.y, mPopupRect.width, mPopupRect.height);
+        read(mPopupBuffer.getData(), mPopupWidth, mPopupHeight, mPopupFrameCount, bounds);
+        return true;
+    }
 
-    juce::OpenGLContext* mOpenGLContext;
-    uint32* mBuffer;
-    int mBufferWidth;
-    int mBufferHeight;
+    // Takes effect once the browser host is told the screen info changed.
+    void setRenderScale(float scale)
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        mRenderScale = juce::jlimit(0.25f, 1.0f, scale);
+        mFrameTimeMs = 0.0;
+    }
 
-    IMPLEMENT_REFCOUNTING(RenderHandler);
-};
+    float getRenderScale() const
+    {
+        return mRenderScale;
+    }
+
+    // Average time between the paints of an animation, how fast Chromium
+    // keeps up, and how long it has not painted at all.
+    double getFrameTimeMs() const
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        return mFrameTimeMs;
+    }
+
+    double getMsSinceLastPaint() const
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        return juce::Time::getMillisecondCounterHiRes() - mLastPaintAt;
+    }
+
+    // Number of frames painted so far, tells a reopened editor when the
+    // browser has painted again.
+    juce::uint32 getFrameCount() const
+    {
+        return mFrameCount.load();
+    }
+
+public:
+    // Input to photon: an input was sent to the browser at the given time,
+    // measured from the oldest one not painted yet. Only a paint whose dirty
+    // rects touch the target, in view pixels, answers it. An empty target
+    // is answered by any paint, e.g. for a wheel or a drag.
+    void markInput(double timeMs, juce::Rectangle<int> target)
+    {
+        const juce::SpinLock::ScopedLockType sl(mInputLock);
+        if (mPendingInputTime <= 0.0)
+        {
+            mPendingInputTime = timeMs;
+            mPendingInputTarget = target;
+            mPendingInputAnywhere = target.isEmpty();
+        }
+        else
+        {
+            mPendingInputTarget = mPendingInputTarget.getUnion(target);
+            mPendingInputAnywhere = mPendingInputAnywhere || target.isEmpty();
+        }
+    }
+
+    // Called after presenting a frame at least frameCount, returns the input
+    // it answers and when that was painted, once.
+    bool takePresentedInput(juce::uint32 frameCount, double& outInputTime, double& outPaintTime)
+    {
+        const juce::SpinLock::ScopedLockType sl(mInputLock);
+        if (mPaintedFrame == 0 || mPaintedFrame > frameCount)
+        {
+            return false;
+        }
+        outInputTime = mPaintedInputTime;
+        outPaintTime = mPaintedAt;
+        mPaintedFrame = 0;
+        return true;
+    }
 
-class RequestContextHandler :public CefRequestContextHandler
-{
 public:
-    RequestContextHandler()
+    // Last complete frame, kept while no editor shows the browser. Stored
+    // like the live frame, see readFrame().
+    struct Snapshot
     {
-        mCookieManager = CefCookieManager::CreateManager("D:/CefCookie", FALSE, nullptr);
+        int width = 0;
+        int height = 0;
+        float scale = 1.0f;
+        juce::HeapBlock<uint32> pixels;
+
+        ~Snapshot()     { sSnapshotBytes -= getBytes(); }
+        juce::int64 getBytes() const    { return ((juce::int64)width * height) << 2; }
     };
-    virtual ~RequestContextHandler()
+
+    // Called when an editor detaches, copies only the painted area. Halves it
+    // until it fits kMaxSnapshotPixels, and keeps none once the pool's
+    // snapshots would exceed kSnapshotBudgetBytes, the editor then opens on
+    // its placeholder.
+    void takeSnapshot()
     {
-    };
-    virtual CefRefPtr<CefCookieManager> GetCookieManager() override
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        mSnapshot = nullptr;
+        if (mBufferWidth <= 0 || mBufferHeight <= 0)
+        {
+            return;
+        }
+
+        int factor = 1;
+        while ((juce::int64)(mBufferWidth / factor) * (mBufferHeight / factor) > kMaxSnapshotPixels)
+        {
+            factor *= 2;
+        }
+
+        juce::ScopedPointer<Snapshot> snapshot(new Snapshot());
+        snapshot->width = juce::jmax(1, mBufferWidth / factor);
+        snapshot->height = juce::jmax(1, mBufferHeight / factor);
+        snapshot->scale = mBufferScale / (float)factor;
+        if (sSnapshotBytes.fetch_add(snapshot->getBytes()) + snapshot->getBytes() > kSnapshotBudgetBytes)
+        {
+            return;
+        }
+
+        snapshot->pixels.malloc((size_t)snapshot->width * (size_t)snapshot->height);
+        downscale(mBuffer, mBufferWidth, snapshot->pixels, snapshot->width, snapshot->height, factor);
+        mSnapshot = snapshot.release();
+    }
+
+    // Held by the snapshots of every browser in the process.
+    static juce::int64 getSnapshotBytes()          { return sSnapshotBytes.load(); }
+
+    // Stale once the page is reloaded for another instance.
+    void clearSnapshot()
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        mSnapshot = nullptr;
+    }
+
+    bool hasSnapshot() const
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        return mSnapshot != nullptr;
+    }
+
+    // Hands the snapshot to the given function, returns false if there is none.
+    template <typename ReadFunction>
+    bool readSnapshot(ReadFunction&& read) const
+    {
+        const juce::SpinLock::ScopedLockType sl(mBufferLock);
+        if (mSnapshot == nullptr)
+        {
+            return false;
+        }
+        read(*mSnapshot);
+        return true;
+    }
+
+private:
+    // Dirty rects come in buffer pixels, the target is in view pixels.
+    bool touchesInputTarget(const RectList& dirtyRects, float bufferScale) const
     {
-        return mCookieManager;
+        for (const CefRect& rect : dirtyRects)
+        {
+            const juce::Rectangle<float> dirty((float)rect.x, (float)rect.y, (float)rect.width, (float)rect.height);
+            if ((dirty / bufferScale).getSmallestIntegerContainer().intersects(mPendingInputTarget))
+            {
+                return true;
+            }
+        }
+        return false;
     }
-    
+
+    // Averages factor x factor blocks, per 8 bit channel.
+    static void downscale(const uint32* src, int srcWidth, uint32* dest, int width, int height, int factor)
+    {
+        if (factor == 1)
+        {
+            memcpy(dest, src, ((size_t)width * (size_t)height) << 2);
+            return;
+        }
+
+        const uint32 area = (uint32)(factor * factor);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                uint32 sums[4] = { 0, 0, 0, 0 };
+                for (int dy = 0; dy < factor; ++dy)
+                {
+                    const uint32* row = src + (size_t)(y * factor + dy) * (size_t)srcWidth + (size_t)(x * factor);
+                    for (int dx = 0; dx < factor; ++dx)
+                    {
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            sums[c] += (row[dx] >> (8 * c)) & 0xff;
+                        }
+                    }
+                }
+                dest[(size_t)y * (size_t)width + (size_t)x] = (sums[0] / area) | ((sums[1] / area) << 8)
+                                                            | ((sums[2] / area) << 16) | ((sums[3] / area) << 24);
+            }
+        }
+    }
+
 private:
-    CefRefPtr<CefCookieManager> mCookieManager;
+    static std::atomic<juce::int64> sSnapshotBytes;
 
-    // Include the default reference counting implementation.
-    IMPLEMENT_REFCOUNTING(RequestContextHandler);
+    int mWidth;
+    int mHeight;
+
+    juce::OpenGLContext* mOpenGLContext;
+    uint32* mBuffer;
+    int mBufferWidth;
+    int mBufferHeight;
+    std::atomic<juce::uint32> mFrameCount;
+    juce::ScopedPointer<Snapshot> mSnapshot;
+    juce::SpinLock mBufferLock;
+
+    double mPendingInputTime;
+    juce::Rectangle<int> mPendingInputTarget;
+    bool mPendingInputAnywhere;
+    double mPaintedInputTime;
+    double mPaintedAt;
+    juce::uint32 mPaintedFrame;     // 0 when no painted input waits to be presented
+    juce::SpinLock mInputLock;
+
+    std::atomic<float> mRenderScale;
+    float mBufferScale;
+    double mLastPaintAt;
+    double mFrameTimeMs;
+
+    bool mPopupVisible;
+    CefRect mPopupRect;
+    juce::HeapBlock<uint32> mPopupBuffer;
+    int mPopupWidth;
+    int mPopupHeight;
+    juce::uint32 mPopupFrameCount;
+
+    IMPLEMENT_REFCOUNTING(RenderHandler);
 };
 
 class BrowserClient
@@ -115,8 +453,14 @@ class BrowserClient
     , public CefLoadHandler
 {
 public:
-    BrowserClient(CefRefPtr<CefRenderHandler> ptr)
+    BrowserClient(CefRefPtr<CefRenderHandler> ptr, CefRefPtr<App> inApp, std::function<void()> inOnCreated)
         : mRenderHandler(ptr)
+        , mApp(inApp)
+        , mAudioProcessor(nullptr)
+        , mOnCreated(inOnCreated)
+        , mCloseRequested(false)
+        , mClosed(true)
+        , mContextSetup(0.01, 500)
     {
     }
 
@@ -136,14 +480,95 @@ public: // CefClient
         return mRenderHandler;
     }
 
+    virtual bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                          CefProcessId source_process,
+                                          CefRefPtr<CefProcessMessage> message) override
+    {
+        if (message->GetName() == RendererApp::sNativeWidgetsMessage)
+        {
+            setNativeWidgets(message->GetArgumentList());
+            return true;
+        }
+        if (message->GetName() == RendererApp::sContextSetupMessage)
+        {
+            mContextSetup.add(message->GetArgumentList()->GetDouble(0));
+            return true;
+        }
+        if (message->GetName() == RendererApp::sRpcMessage)
+        {
+            const juce::String batch(message->GetArgumentList()->GetString(0).ToString());
+            const juce::ScopedLock sl(mRpcLock);
+            if (mRpcServer != nullptr)
+            {
+                mRpcServer->dispatch(browser, batch);
+            }
+            else
+            {
+                // lent to no instance
+                RpcServer::reject(browser, batch, "unavailable");
+            }
+            return true;
+        }
+        if (message->GetName() == BinaryChannel::sMessage)
+        {
+            juce::String topic;
+            juce::MemoryBlock data;
+            double ms;
+            if (mAssembler.add(message->GetArgumentList(), topic, data, ms))
+            {
+                mBinaryStats.addReceived(data.getSize(), ms);
+                const juce::ScopedLock sl(mBinaryLock);
+                if (mBinaryListener)
+                {
+                    mBinaryListener(topic, data);
+                }
+            }
+            return true;
+        }
+        if (message->GetName() != RendererApp::sSetParameterMessage)
+        {
+            return false;
+        }
+
+        // a page in the browser helper moved a parameter
+        const juce::ScopedLock sl(mLock);
+        if (mAudioProcessor != nullptr)
+        {
+            CefRefPtr<CefListValue> args = message->GetArgumentList();
+            if (juce::AudioProcessorParameter* param = mAudioProcessor->getParameters()[args->GetInt(0)])
+            {
+                param->setValueNotifyingHost((float)args->GetDouble(1));
+            }
+        }
+        return true;
+    }
+
 public: // CefLifeSpanHandler
     virtual void OnAfterCreated(CefRefPtr<CefBrowser> browser) override
     {
         // Must be executed on the UI thread.
         //CEF_REQUIRE_UI_THREAD();
 
-        OutputDebugStringW(L"OnAfterCreated\n");
+        CEFPLUGIN_LOG_DEBUG("browser", "OnAfterCreated id=%d", browser->GetIdentifier());
+        StartupTracer::endAsync("BrowserCreation", getTraceId());
+        StartupTracer::addInstant("OnAfterCreated", browser->GetIdentifier());
+        const juce::ScopedLock sl(mLock);
         mBrowser = browser;
+        if (mCloseRequested)
+        {
+            // the owner went away before the browser was created
+            browser->GetHost()->CloseBrowser(true);
+            return;
+        }
+        if (mAudioProcessor != nullptr)
+        {
+            mApp->registerBrowser(browser->GetIdentifier(), mAudioProcessor);
+            sendParameters(true);
+        }
+        if (mOnCreated)
+        {
+            mOnCreated();
+        }
     }
 
     virtual bool DoClose(CefRefPtr<CefBrowser> browser) override
@@ -167,7 +592,9 @@ public: // CefLifeSpanHandler
 
     virtual void OnBeforeClose(CefRefPtr<CefBrowser> browser) override
     {
-        OutputDebugStringW(L"OnBeforeClose()\n");
+        CEFPLUGIN_LOG_DEBUG("browser", "OnBeforeClose id=%d", browser->GetIdentifier());
+        mApp->unregisterBrowser(browser->GetIdentifier());
+        mClosed.signal();
     }
 
 
@@ -177,7 +604,7 @@ public: // CefLifeSpanHandler
                                 const CefString & errorText,
                                 const CefString & failedUrl) override
     {
-        OutputDebugStringW(L"OnLoadError()\n");
+        CEFPLUGIN_LOG_WARNING("browser", "OnLoadError id=%d error=%d url=%s", browser->GetIdentifier(), (int)errorCode, failedUrl.ToString().c_str());
         mLoaded = true;
     }
 
@@ -186,22 +613,33 @@ public: // CefLifeSpanHandler
                                         bool canGoBack,
                                         bool canGoForward) override
     {
-        OutputDebugStringW(L"OnLoadingStateChange()\n");
+        CEFPLUGIN_LOG_TRACE("browser", "OnLoadingStateChange id=%d loading=%d", browser->GetIdentifier(), (int)isLoading);
     }
 
     virtual void OnLoadStart(CefRefPtr<CefBrowser> browser,
                                 CefRefPtr<CefFrame> frame,
                                 TransitionType transition_type) override
     {
-        OutputDebugStringW(L"OnLoadStart()\n");
+        CEFPLUGIN_LOG_DEBUG("browser", "OnLoadStart id=%d main=%d", browser->GetIdentifier(), (int)frame->IsMain());
+        if (frame->IsMain())
+        {
+            StartupTracer::beginAsync("PageLoad", getTraceId());
+
+            // the new page declares its own
+            const juce::SpinLock::ScopedLockType sl(mWidgetLock);
+            mNativeWidgets.clearQuick();
+        }
     }
 
     virtual void OnLoadEnd(CefRefPtr<CefBrowser> browser,
                             CefRefPtr<CefFrame> frame,
                             int httpStatusCode) override
     {
-        OutputDebugStringW(L"OnLoadEnd()\n");
-        std::cout << "OnLoadEnd(" << httpStatusCode << ")" << std::endl;
+        CEFPLUGIN_LOG_DEBUG("browser", "OnLoadEnd id=%d main=%d status=%d", browser->GetIdentifier(), (int)frame->IsMain(), httpStatusCode);
+        if (frame->IsMain())
+        {
+            StartupTracer::endAsync("PageLoad", getTraceId());
+        }
         mLoaded = true;
     }
 public:
@@ -215,214 +653,332 @@ public:
         return mLoaded;
     }
 
-    CefRefPtr<CefBrowser> GetBrower() {return mBrowser;}
+    CefRefPtr<CefBrowser> GetBrower()
+    {
+        const juce::ScopedLock sl(mLock);
+        return mBrowser;
+    }
 
-private:
-    bool mClosing = false;
-    bool mLoaded = false;
-    CefRefPtr<CefRenderHandler> mRenderHandler;
-    CefRefPtr<CefBrowser> mBrowser;
+    // Binds the page's window.parameters to a processor, nullptr unbinds it.
+    // The previous processor is unreachable from the page once this returns.
+    void setAudioProcessor(juce::AudioProcessor* inAudioProcessor)
+    {
+        const juce::ScopedLock sl(mLock);
+        mAudioProcessor = inAudioProcessor;
+        if (mBrowser == nullptr || mCloseRequested)
+        {
+            return;
+        }
+        if (mAudioProcessor != nullptr)
+        {
+            mApp->registerBrowser(mBrowser->GetIdentifier(), mAudioProcessor);
+            sendParameters(true);
+        }
+        else
+        {
+            mApp->unregisterBrowser(mBrowser->GetIdentifier());
+        }
+    }
 
-    IMPLEMENT_REFCOUNTING(BrowserClient);
-};
+    // The regions the page wants drawn natively, callable from any thread.
+    void getNativeWidgets(juce::Array<NativeWidget>& outWidgets) const
+    {
+        const juce::SpinLock::ScopedLockType sl(mWidgetLock);
+        outWidgets = mNativeWidgets;
+    }
 
-class App
-    : public CefApp
-    , public CefRenderProcessHandler
-    , public CefV8Interceptor
-{
-public:
-    App(juce::AudioProcessor* inAudioProcessor)
-        : mAudioProcessor(inAudioProcessor)
-        , mParams(inAudioProcessor->getParameters())
-        , mGain(1)
+    bool hasNativeWidgets() const
     {
+        const juce::SpinLock::ScopedLockType sl(mWidgetLock);
+        return !mNativeWidgets.isEmpty();
     }
 
-public: // CefApp
-    virtual CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() {
-        return this;
+    // Sends a payload to the page's binaryChannel.onmessage, any thread.
+    bool sendBinary(const juce::String& topic, const void* data, size_t size)
+    {
+        if (!BinaryChannel::send(GetBrower(), PID_RENDERER, topic, data, size))
+        {
+            return false;
+        }
+        mBinaryStats.addSent(size);
+        return true;
     }
 
-public: // CefRenderProcessHandler
-    virtual void OnContextCreated(CefRefPtr<CefBrowser> browser,
-                                  CefRefPtr<CefFrame> frame,
-                                  CefRefPtr<CefV8Context> context)
+    // Receives what the page sends with binaryChannel.send(), on CEF's UI
+    // thread. Once this returns the previous listener is not called anymore.
+    void setBinaryListener(std::function<void(const juce::String& topic, const juce::MemoryBlock& data)> listener)
     {
-        //// Retrieve the context's window object.
-        CefRefPtr<CefV8Value> window = context->GetGlobal();
-        //
-        //// Create a new V8 string value. See the "Basic JS Types" section below.
-        //CefRefPtr<CefV8Value> str = CefV8Value::CreateString("My Value!");
-        //
-        //// Add the string to the window object as "window.myval". See the "JS Objects" section below.
-        //object->SetValue("myval", str, V8_PROPERTY_ATTRIBUTE_NONE);
+        const juce::ScopedLock sl(mBinaryLock);
+        mBinaryListener = listener;
+    }
 
-        CefRefPtr<CefV8Value> object = CefV8Value::CreateObject(nullptr, this);
+    juce::var getBinaryMetrics() const
+    {
+        return mBinaryStats.getMetrics();
+    }
 
-        CefString objName("parameters");
+    // Serves the page's nativeRpc calls, nullptr rejects them. No batch is
+    // dispatched to the previous server once this returns.
+    void setRpcServer(RpcServer* inRpcServer)
+    {
+        const juce::ScopedLock sl(mRpcLock);
+        mRpcServer = inRpcServer;
+    }
 
-        object->SetValue(objName, V8_ACCESS_CONTROL_DEFAULT, V8_PROPERTY_ATTRIBUTE_NONE);
-        window->SetValue(objName, object, V8_PROPERTY_ATTRIBUTE_NONE);
-     }
+    // ms each V8 context of this browser spent setting up window.parameters
+    // and the rest, iframes and reloads included.
+    const AtomicHistogram& getContextSetupTimes() const
+    {
+        return mContextSetup;
+    }
+
+    // The page's shared canvas, only ever created in a single process.
+    SharedCanvas::Ptr getSharedCanvas()
+    {
+        CefRefPtr<CefBrowser> browser = GetBrower();
+        return browser != nullptr ? mApp->getSharedCanvas(browser->GetIdentifier()) : nullptr;
+    }
+
+    // With the browser helper the page reads a copy of the parameters, this
+    // refreshes it when a value changed. Does nothing in a single process.
+    void syncParameters()
+    {
+        const juce::ScopedLock sl(mLock);
+        sendParameters(false);
+    }
 
-public: // CefV8Interceptor
-    virtual bool Get(const CefString& name,
-                     const CefRefPtr<CefV8Value> object,
-                     CefRefPtr<CefV8Value>& retval,
-                     CefString& exception) override
+    // Closes the browser and waits for CEF to confirm, the processor must not
+    // be reachable from the page anymore once this returns.
+    void closeBrowser(int timeoutMs)
     {
-        for (const auto& param : mParams)
+        CefRefPtr<CefBrowser> browser;
         {
-            if (param->getName(name.length()) == juce::String(name))
+            const juce::ScopedLock sl(mLock);
+            if (mCloseRequested)
             {
-                retval = CefV8Value::CreateDouble(param->getValue());
-                return true;
+                return;
             }
+            mCloseRequested = true;
+            browser = mBrowser;
+            mAudioProcessor = nullptr;
+            mOnCreated = nullptr;
         }
-        return false;
+        if (browser == nullptr)
+        {
+            // still being created, OnAfterCreated() closes it
+            return;
+        }
+        mApp->unregisterBrowser(browser->GetIdentifier());
+        browser->GetHost()->CloseBrowser(true);
+#if CEFPLUGIN_EXTERNAL_MESSAGE_PUMP
+        // CEF runs on this thread, the close only goes through while pumping
+        CefMessagePump::waitPumping(mClosed, timeoutMs);
+#else
+        mClosed.wait(timeoutMs);
+#endif
     }
 
-    virtual bool Get(int index,
-                     const CefRefPtr<CefV8Value> object,
-                     CefRefPtr<CefV8Value>& retval,
-                     CefString& exception) override
+private:
+    // Must be called with mLock held.
+    void sendParameters(bool force)
     {
-        return true;
-    }
+        if (mBrowser == nullptr || mAudioProcessor == nullptr || mCloseRequested)
+        {
+            return;
+        }
+        if (!mApp->isMultiProcess() && !force)
+        {
+            // the page reads the processor itself, it only needs the names
+            // once in case it loaded before the browser was lent
+            return;
+        }
 
+        const juce::OwnedArray<juce::AudioProcessorParameter>& params = mAudioProcessor->getParameters();
+        bool changed = force || mSentParameters.size() != params.size();
+        mSentParameters.resize(params.size());
+        for (int i = 0; i < params.size(); ++i)
+        {
+            const float value = params[i]->getValue();
+            changed = changed || mSentParameters[i] != value;
+            mSentParameters.set(i, value);
+        }
+        if (!changed)
+        {
+            return;
+        }
 
-    virtual bool Set(const CefString& name,
-                     const CefRefPtr<CefV8Value> object,
-                     const CefRefPtr<CefV8Value> value,
-                     CefString& exception) override
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(RendererApp::sParametersMessage);
+        CefRefPtr<CefListValue> args = message->GetArgumentList();
+        for (int i = 0; i < params.size(); ++i)
+        {
+            args->SetString(2 * i, params[i]->getName(256).toStdString());
+            args->SetDouble(2 * i + 1, mSentParameters[i]);
+        }
+        mBrowser->SendProcessMessage(PID_RENDERER, message);
+    }
+
+    void setNativeWidgets(CefRefPtr<CefListValue> args)
     {
-        for (const auto& param : mParams)
+        juce::Array<NativeWidget> widgets;
+        for (size_t i = 0; i + 5 < args->GetSize(); i += 6)
         {
-            if (param->getName(name.length()) == juce::String(name))
+            NativeWidget widget;
+            widget.id = juce::String(args->GetString(i).ToString());
+            if (NativeWidget::parseKind(juce::String(args->GetString(i + 1).ToString()), widget.kind))
             {
-                jassert(value->IsDouble());
-                param->setValueNotifyingHost((float)value->GetDoubleValue());
-                return true;
+                widget.bounds.setBounds(args->GetInt(i + 2), args->GetInt(i + 3), args->GetInt(i + 4), args->GetInt(i + 5));
+                widgets.add(widget);
             }
         }
 
-        return false;
+        const juce::SpinLock::ScopedLockType sl(mWidgetLock);
+        mNativeWidgets.swapWith(widgets);
     }
 
-    virtual bool Set(int index,
-                     const CefRefPtr<CefV8Value> object,
-                     const CefRefPtr<CefV8Value> value,
-                     CefString& exception) override
+    // Matches the BrowserCreation span BrowserPool begins.
+    juce::int64 getTraceId() const
     {
-        return true;
+        return (juce::int64)(juce::pointer_sized_int)this;
     }
 
-public:
-    double mGain; 
+private:
+    bool mClosing = false;
+    bool mLoaded = false;
+    CefRefPtr<CefRenderHandler> mRenderHandler;
+    CefRefPtr<CefBrowser> mBrowser;
+    CefRefPtr<App> mApp;
     juce::AudioProcessor* mAudioProcessor;
-    const juce::OwnedArray<juce::AudioProcessorParameter>& mParams;
+    std::function<void()> mOnCreated;
+    juce::Array<float> mSentParameters;
+    bool mCloseRequested;
+    juce::WaitableEvent mClosed;
+    juce::CriticalSection mLock;
+    juce::Array<NativeWidget> mNativeWidgets;
+    juce::SpinLock mWidgetLock;
+    BinaryChannel::Assembler mAssembler;            // UI thread only
+    BinaryChannel::Stats mBinaryStats;
+    std::function<void(const juce::String&, const juce::MemoryBlock&)> mBinaryListener;
+    juce::CriticalSection mBinaryLock;
+    RpcServer* mRpcServer = nullptr;
+    juce::CriticalSection mRpcLock;
+    AtomicHistogram mContextSetup;
 
-public:
-    IMPLEMENT_REFCOUNTING(App);
+    IMPLEMENT_REFCOUNTING(BrowserClient);
 };
 
+class BrowserPool;
+class PooledBrowser;
+
+// Owns the browser lease of one plugin instance. Nothing happens at
+// construction: the shared browser pool, and with it CEF, is joined when the
+// editor opens or shortly after the host prepares the plugin to play, so hosts
+// that only scan or render it headless never load Chromium. An open editor
+// borrows a preloaded browser from the pool and gives it back on close.
 class BrowserManager
+    : private juce::Timer
 {
-private:
-    static BrowserManager* sInstance;
-    static const char* sTestUrl;
-
 public:
-    BrowserManager(juce::AudioProcessor* inAudioProcessor)
-    {    
-        // init CEF
-        CefMainArgs args;
-        CefRefPtr<CefApp> app = new App(inAudioProcessor);
-
-#if 1
-        {
-            int result = CefExecuteProcess(args, app, nullptr);
-            // checkout CefApp, derive it and set it as second parameter, for more control on
-            // command args and resources.
-            if (result >= 0) // child proccess has endend, so exit.
-            {
-                return;
-            }
-            else if (result == -1)
-            {
-                // we are here in the father proccess.
-            }
-        }
-#endif
-
-        {
-            CefSettings settings;
-
-            // CefString(&settings.resources_dir_path).FromASCII("");
-            // checkout detailed settings options:
-            // http://magpcss.org/ceforum/apidocs/projects/%28default%29/_cef_settings_t.html
-            // nearly all the settings can be set via args too.
-            settings.single_process = true;
-            settings.multi_threaded_message_loop = true; // not supported, except windows
-            // settings.single_process = true; // not supported, except windows
-            // settings.remote_debugging_port = 8090;
-            // CefString(&settings.browser_subprocess_path).FromASCII("sub_proccess path, by default uses and starts this executeable as child");
-            // CefString(&settings.cache_path).FromASCII("");
-            // CefString(&settings.log_file).FromASCII("");
-            // settings.log_severity = LOGSEVERITY_DEFAULT;
-
-            bool result = CefInitialize(args, settings, app, nullptr);
-            // CefInitialize creates a sub-proccess and executes the same executeable,
-            // as calling CefInitialize, if not set different in settings.browser_subprocess_path
-            // if you create an extra program just for the childproccess you only have to call CefExecuteProcess(...) in it.
-            if (!result)
-            {
-                // handle error
-                return;
-            }
-        }
-
-        mRenderHandler = new RenderHandler(800, 600);
-        mBrowserClient = new BrowserClient(mRenderHandler);
-
-        CefWindowInfo window_info;
-        CefBrowserSettings browserSettings;
-
-        // browserSettings.windowless_frame_rate = 60; // 30 is default
-
-        //window_info.SetAsWindowless((HWND) getWindowHandle());
-        window_info.SetAsWindowless(NULL);
-
-        CefRequestContextSettings reqsettings;
-        CefRefPtr<CefRequestContext> rc = CefRequestContext::GetGlobalContext();
+    static const char* sTestUrl;
+    static juce::String getStartUrl();
 
-        CefBrowserHost::CreateBrowser(window_info, mBrowserClient.get(), sTestUrl, browserSettings, rc);
-    }
+private:
+    enum
+    {
+        kWarmUpDelayMs = 1500
+    };
 
 public:
-    //static BrowserManager* getInstance()
-    //{
-    //    if (sInstance == nullptr)
-    //    {
-    //        sInstance = new BrowserManager();
-    //    }
-    //
-    //    return sInstance;
-    //}
-
-    CefRefPtr<RenderHandler> getRenderHandler()
-    {
-        return mRenderHandler;
-    }
+    BrowserManager(juce::AudioProcessor* inAudioProcessor);
+    ~BrowserManager();
 
-    CefRefPtr<CefBrowser> getBrowser()
-    {
-        return mBrowserClient->GetBrower();
-    }
+public:
+    // Borrows a browser from the pool if not done yet, never blocks.
+    void start();
+
+    // Gives the browser back to the pool, the page stays loaded for next time.
+    void stop();
+
+    // Joins the pool in the background ahead of the editor, once the instance
+    // is in a session the host plays. Any thread.
+    void warmUp();
+
+    // Becomes true once the browser exists, false if CEF could not start.
+    // Only valid between start() and stop().
+    std::shared_future<bool> getReadiness() const;
+
+    CefRefPtr<RenderHandler> getRenderHandler() const;
+    CefRefPtr<CefBrowser> getBrowser() const;
+
+    // Extra browsers the editor composites over the main one, each at its
+    // own frame rate, e.g. a fast meter strip over a slow main page. They
+    // only display, input goes to the main browser. Added after start(),
+    // closed by stop(). The getters may be called from the GL thread.
+    int addLayer(const juce::String& url, juce::Rectangle<int> bounds, int frameRate);
+    int getNumLayers() const;
+    CefRefPtr<RenderHandler> getLayerRenderHandler(int index) const;
+    juce::Rectangle<int> getLayerBounds(int index) const;
+
+    // Regions the main page declared for native drawing, between start() and
+    // stop(). May be called from the GL thread.
+    void getNativeWidgets(juce::Array<NativeWidget>& outWidgets) const;
+    bool hasNativeWidgets() const;
+
+    // The canvas the main page writes from JS, nullptr if it has none. May be
+    // called from the GL thread.
+    SharedCanvas::Ptr getSharedCanvas() const;
+
+    // Typed arrays to and from the main page, see BinaryChannel. The listener
+    // is called on CEF's UI thread and must be reset before stop().
+    bool sendBinary(const juce::String& topic, const void* data, size_t size);
+    void setBinaryListener(std::function<void(const juce::String& topic, const juce::MemoryBlock& data)> listener);
+    juce::var getBinaryChannelMetrics() const;
+
+    // Calls and batches served to the page's nativeRpc. Methods are added
+    // before start(), e.g. by the processor that owns this.
+    void addRpcMethod(const juce::String& name, RpcServer::Method method)   { mRpc.addMethod(name, method); }
+    juce::var getRpcMetrics() const                 { return mRpc.getMetrics(); }
+
+    // Pushes changed parameter values to a page in the browser helper.
+    void syncParameters();
+
+    juce::var getPoolMetrics() const;
+    juce::var getMessagePumpMetrics();
+
+    // Editor open to first frame on screen, in milliseconds, over the
+    // instance's lifetime.
+    AtomicHistogram& getSnapshotFrameLatency()      { return mSnapshotFrameLatency; }
+    AtomicHistogram& getLiveFrameLatency()          { return mLiveFrameLatency; }
+    juce::var getEditorOpenMetrics() const;
+
+    // Input sent to the browser to the frame that answers it, painted and on
+    // screen, in milliseconds.
+    void addInputLatency(double paintMs, double presentMs);
+    void resetInputLatency();
+    double getInputLatencyPercentile(double fraction) const     { return mInputToPresentLatency.getPercentile(fraction); }
+    juce::int64 getNumInputLatencySamples() const               { return mInputToPresentLatency.getCount(); }
+    juce::var getInputLatencyMetrics() const;
 
+private:
+    void timerCallback() override;
+    void joinPool();
+    void addRpcMethods();
 
 private:
-    CefRefPtr<RenderHandler> mRenderHandler;
-    CefRefPtr<BrowserClient> mBrowserClient;
+    juce::AudioProcessor* mAudioProcessor;
+    juce::ScopedPointer<juce::SharedResourcePointer<BrowserPool>> mPool;
+    CefMessagePump::MetricsSnapshot mMessagePumpMetrics;
+    juce::ReferenceCountedObjectPtr<PooledBrowser> mBrowser;
+    RpcServer mRpc;
+
+    struct Layer
+    {
+        juce::ReferenceCountedObjectPtr<PooledBrowser> browser;
+        juce::Rectangle<int> bounds;
+    };
+    juce::Array<Layer> mLayers;
+    juce::SpinLock mLayerLock;
+    AtomicHistogram mSnapshotFrameLatency;
+    AtomicHistogram mLiveFrameLatency;
+    AtomicHistogram mInputToPaintLatency;
+    AtomicHistogram mInputToPresentLatency;
 };
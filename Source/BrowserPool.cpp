@@ -0,0 +1,341 @@
+#include "BrowserPool.h"
+
+PooledBrowser::PooledBrowser(CefRefPtr<App> inApp, const juce::String& inUrl, int width, int height, int inFrameRate, bool inIsLayer)
+    : mRenderHandler(new RenderHandler(width, height))
+    , mBrowserClient(new BrowserClient(mRenderHandler, inApp, [this]() { setReady(true); }))
+    , mReadiness(mReadyPromise.get_future().share())
+    , mUrl(inUrl)
+    , mFrameRate(inFrameRate)
+    , mIsLayer(inIsLayer)
+    , mCreateRequested(false)
+    , mOwner(nullptr)
+    , mLastOwner(nullptr)
+    , mHoldsState(false)
+    , mIdleSince(juce::Time::getMillisecondCounterHiRes())
+{
+}
+
+PooledBrowser::~PooledBrowser()
+{
+    mBrowserClient->closeBrowser(2000);
+    setReady(false);
+}
+
+void PooledBrowser::setReady(bool ready)
+{
+    std::call_once(mReadyOnce, [this, ready]() { mReadyPromise.set_value(ready); });
+}
+
+// ----------------------------------------------------------------------------
+
+BrowserPool::BrowserPool()
+    : mRuntime(CefRuntime::getInstance())
+    , mWarmCount(mSettings->getWarmBrowserCount())
+    , mMemoryBudget(mSettings->getBrowserMemoryBudget())
+    , mIdleTimeoutMs(mSettings->getBrowserIdleTimeoutMs())
+    , mNumSpawned(0)
+    , mNumReused(0)
+    , mNumExpired(0)
+{
+    mRuntime.setIdle(false);
+
+    // spares are spawned as soon as the runtime is up
+    startTimer(kPollIntervalMs);
+}
+
+BrowserPool::~BrowserPool()
+{
+    stopTimer();
+
+    // the runtime stays for the next instance, with no browser left behind
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        jassert(browser->mOwner == nullptr);
+        browser->mBrowserClient->closeBrowser(2000);
+    }
+    mBrowsers.clear();
+
+    jassert(mLayers.isEmpty());
+    for (PooledBrowser* layer : mLayers)
+    {
+        layer->mBrowserClient->closeBrowser(2000);
+    }
+    mLayers.clear();
+
+    mRuntime.setIdle(true);
+}
+
+// ----------------------------------------------------------------------------
+
+PooledBrowser::Ptr BrowserPool::acquire(juce::AudioProcessor* owner)
+{
+    // prefer the browser this instance used last, then a fresh spare
+    PooledBrowser* best = nullptr;
+    int bestScore = 0;
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        if (browser->mOwner != nullptr)
+        {
+            continue;
+        }
+
+        const int score = !browser->mHoldsState ? 2 : (browser->mLastOwner == owner ? 3 : 1);
+        if (score > bestScore)
+        {
+            best = browser;
+            bestScore = score;
+        }
+    }
+
+    if (best == nullptr)
+    {
+        best = spawn();
+    }
+    else
+    {
+        ++mNumReused;
+    }
+
+    CefRefPtr<CefBrowser> cefBrowser = best->getBrowser();
+    if (best->mHoldsState && best->mLastOwner != owner && cefBrowser != nullptr)
+    {
+        // the page still holds another instance's state
+        cefBrowser->GetMainFrame()->LoadURL(BrowserManager::getStartUrl().toStdString());
+        best->getRenderHandler()->clearSnapshot();
+    }
+
+    best->mOwner = owner;
+    best->mLastOwner = owner;
+    best->mHoldsState = true;
+    best->mBrowserClient->setAudioProcessor(owner);
+
+    if (cefBrowser != nullptr)
+    {
+        cefBrowser->GetHost()->WasHidden(false);
+        cefBrowser->GetHost()->Invalidate(PET_VIEW);
+        cefBrowser->GetMainFrame()->ExecuteJavaScript("if (window.onPluginAttached) window.onPluginAttached();", "", 0);
+    }
+
+    timerCallback();
+    return best;
+}
+
+void BrowserPool::release(PooledBrowser::Ptr browser)
+{
+    if (browser == nullptr)
+    {
+        return;
+    }
+
+    browser->mBrowserClient->setAudioProcessor(nullptr);
+    browser->mOwner = nullptr;
+    browser->mIdleSince = juce::Time::getMillisecondCounterHiRes();
+
+    if (CefRefPtr<CefBrowser> cefBrowser = browser->getBrowser())
+    {
+        cefBrowser->GetHost()->WasHidden(true);
+    }
+}
+
+PooledBrowser::Ptr BrowserPool::createLayer(juce::AudioProcessor* owner, const juce::String& url, int width, int height, int frameRate)
+{
+    PooledBrowser* layer = mLayers.add(new PooledBrowser(mRuntime.getApp(), url, width, height, frameRate, true));
+    layer->mOwner = owner;
+    layer->mBrowserClient->setAudioProcessor(owner);
+
+    if (mRuntime.isInitialised())
+    {
+        createPendingBrowsers();
+    }
+    return layer;
+}
+
+void BrowserPool::releaseLayer(PooledBrowser::Ptr layer)
+{
+    if (layer == nullptr)
+    {
+        return;
+    }
+
+    layer->mBrowserClient->setAudioProcessor(nullptr);
+    layer->mBrowserClient->closeBrowser(2000);
+    layer->setReady(false);
+    mLayers.removeObject(layer);
+}
+
+void BrowserPool::forgetOwner(juce::AudioProcessor* owner)
+{
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        if (browser->mLastOwner == owner)
+        {
+            // another instance may later be created at the same address
+            browser->mLastOwner = nullptr;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+int BrowserPool::getTargetWarmCount() const
+{
+    int numInUse = 0;
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        if (browser->mOwner != nullptr)
+        {
+            ++numInUse;
+        }
+    }
+
+    // browsers in use count against the budget, spares get what is left
+    const juce::int64 available = mMemoryBudget - (juce::int64)numInUse * kEstimatedBrowserBytes;
+    return (int)juce::jlimit<juce::int64>(0, mWarmCount, available / kEstimatedBrowserBytes);
+}
+
+juce::var BrowserPool::getMetrics() const
+{
+    int numIdle = 0;
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        if (browser->mOwner == nullptr)
+        {
+            ++numIdle;
+        }
+    }
+
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("browsers", mBrowsers.size());
+    metrics->setProperty("idle", numIdle);
+    metrics->setProperty("targetWarm", getTargetWarmCount());
+    metrics->setProperty("spawned", mNumSpawned);
+    metrics->setProperty("reused", mNumReused);
+    metrics->setProperty("expired", mNumExpired);
+    metrics->setProperty("snapshotBytes", RenderHandler::getSnapshotBytes());
+    return juce::var(metrics);
+}
+
+// ----------------------------------------------------------------------------
+
+void BrowserPool::timerCallback()
+{
+    if (mRuntime.getReadiness().wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        startTimer(kPollIntervalMs);
+        return;
+    }
+
+    if (!mRuntime.isInitialised())
+    {
+        stopTimer();
+        for (PooledBrowser* browser : mBrowsers)
+        {
+            browser->setReady(false);
+        }
+        for (PooledBrowser* layer : mLayers)
+        {
+            layer->setReady(false);
+        }
+        return;
+    }
+
+    createPendingBrowsers();
+
+    // close the idle browsers above the warm count once they timed out, oldest first
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const int targetWarmCount = getTargetWarmCount();
+
+    juce::Array<PooledBrowser*> idle;
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        if (browser->mOwner == nullptr)
+        {
+            idle.add(browser);
+        }
+    }
+    std::sort(idle.begin(), idle.end(), [](PooledBrowser* a, PooledBrowser* b) { return a->mIdleSince < b->mIdleSince; });
+
+    int numIdle = idle.size();
+    for (PooledBrowser* browser : idle)
+    {
+        if (numIdle <= targetWarmCount || now - browser->mIdleSince < mIdleTimeoutMs)
+        {
+            break;
+        }
+        closeBrowser(browser);
+        ++mNumExpired;
+        --numIdle;
+    }
+
+    // keep enough spares loaded
+    for (; numIdle < targetWarmCount; ++numIdle)
+    {
+        spawn();
+    }
+
+    startTimer(kMaintenanceIntervalMs);
+}
+
+PooledBrowser* BrowserPool::spawn()
+{
+    PooledBrowser* browser = mBrowsers.add(new PooledBrowser(mRuntime.getApp(), BrowserManager::getStartUrl(), 800, 600, 0, false));
+    ++mNumSpawned;
+
+    if (mRuntime.isInitialised())
+    {
+        createPendingBrowsers();
+    }
+    return browser;
+}
+
+void BrowserPool::createPendingBrowsers()
+{
+    for (PooledBrowser* browser : mBrowsers)
+    {
+        createBrowser(browser);
+    }
+    for (PooledBrowser* layer : mLayers)
+    {
+        createBrowser(layer);
+    }
+}
+
+void BrowserPool::createBrowser(PooledBrowser* browser)
+{
+    if (browser->mCreateRequested)
+    {
+        return;
+    }
+    browser->mCreateRequested = true;
+
+    CefWindowInfo window_info;
+    CefBrowserSettings browserSettings;
+
+    if (browser->mFrameRate > 0)
+    {
+        browserSettings.windowless_frame_rate = browser->mFrameRate; // 30 is default
+    }
+    if (browser->mIsLayer)
+    {
+        // blended over the main browser
+        browserSettings.background_color = 0x00000000;
+    }
+
+    //window_info.SetAsWindowless((HWND) getWindowHandle());
+    window_info.SetAsWindowless(NULL);
+
+    // all browsers share the runtime's cache and cookie store
+    CefRefPtr<CefRequestContext> rc = mRuntime.getRequestContext();
+
+    // ends in BrowserClient::OnAfterCreated()
+    StartupTracer::beginAsync("BrowserCreation", (juce::int64)(juce::pointer_sized_int)browser->mBrowserClient.get());
+    const StartupTracer::ScopedSpan span("CreateBrowser");
+    CefBrowserHost::CreateBrowser(window_info, browser->mBrowserClient.get(), browser->mUrl.toStdString(), browserSettings, rc);
+}
+
+void BrowserPool::closeBrowser(PooledBrowser* browser)
+{
+    browser->mBrowserClient->closeBrowser(2000);
+    browser->setReady(false);
+    mBrowsers.removeObject(browser);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <future>
+#include <mutex>
+#include "BrowserManager.h"
+#include "CefRuntime.h"
+#include "PluginSettings.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// One offscreen browser with its render handler, owned by the pool and lent to
+// one plugin instance at a time.
+class PooledBrowser
+    : public juce::ReferenceCountedObject
+{
+public:
+    typedef juce::ReferenceCountedObjectPtr<PooledBrowser> Ptr;
+
+    // A frame rate of 0 keeps CEF's default, layers get a transparent background.
+    PooledBrowser(CefRefPtr<App> inApp, const juce::String& inUrl, int width, int height, int inFrameRate, bool inIsLayer);
+    ~PooledBrowser();
+
+public:
+    CefRefPtr<RenderHandler> getRenderHandler() const   { return mRenderHandler; }
+    CefRefPtr<CefBrowser> getBrowser() const            { return mBrowserClient->GetBrower(); }
+    void syncParameters()                               { mBrowserClient->syncParameters(); }
+    void getNativeWidgets(juce::Array<NativeWidget>& outWidgets) const  { mBrowserClient->getNativeWidgets(outWidgets); }
+    bool hasNativeWidgets() const                       { return mBrowserClient->hasNativeWidgets(); }
+    SharedCanvas::Ptr getSharedCanvas() const           { return mBrowserClient->getSharedCanvas(); }
+    CefRefPtr<BrowserClient> getBrowserClient() const   { return mBrowserClient; }
+
+    // Becomes true once CEF created the browser, false if it never will.
+    std::shared_future<bool> getReadiness() const       { return mReadiness; }
+    void setReady(bool ready);
+
+private:
+    friend class BrowserPool;
+
+    CefRefPtr<RenderHandler>    mRenderHandler;
+    CefRefPtr<BrowserClient>    mBrowserClient;
+    std::promise<bool>          mReadyPromise;
+    std::shared_future<bool>    mReadiness;
+    std::once_flag              mReadyOnce;
+
+    const juce::String          mUrl;
+    const int                   mFrameRate;
+    const bool                  mIsLayer;
+    bool                        mCreateRequested;
+    juce::AudioProcessor*       mOwner;         // current user, nullptr when idle
+    juce::AudioProcessor*       mLastOwner;     // whose page state it still holds
+    bool                        mHoldsState;    // false until first lent out
+    double                      mIdleSince;
+
+    JUCE_DECLARE_NON_COPYABLE(PooledBrowser)
+};
+
+/**
+    Process-wide pool of offscreen browsers, held through a
+    juce::SharedResourcePointer<BrowserPool>.
+
+    A few browsers are spawned and loaded ahead of time so an editor opens
+    instantly. A closed editor gives its browser back: the same instance gets
+    it again with its page untouched, another instance gets it reloaded.
+    Idle browsers above the warm count are closed after a timeout, and the
+    warm count is capped by a memory budget. All three come from
+    PluginSettings when the pool is created.
+*/
+class BrowserPool
+    : private juce::Timer
+{
+public:
+    enum
+    {
+        kEstimatedBrowserBytes = 48 << 20,  // renderer heap, compositor and frame buffers
+        kMaintenanceIntervalMs = 500,
+        kPollIntervalMs = 20
+    };
+
+    BrowserPool();
+    ~BrowserPool();
+
+public:
+    // Never blocks, the browser may still be starting when it is returned.
+    PooledBrowser::Ptr acquire(juce::AudioProcessor* owner);
+    void release(PooledBrowser::Ptr browser);
+
+    // Called when an instance goes away, its last browser is reloaded before reuse.
+    void forgetOwner(juce::AudioProcessor* owner);
+
+    // A dedicated browser an editor composites over its main one, never
+    // pooled. Created as soon as the runtime is up.
+    PooledBrowser::Ptr createLayer(juce::AudioProcessor* owner, const juce::String& url, int width, int height, int frameRate);
+    void releaseLayer(PooledBrowser::Ptr layer);
+
+    juce::var getMetrics() const;
+    CefRuntime& getRuntime()                        { return mRuntime; }
+
+private:
+    void timerCallback() override;
+    int getTargetWarmCount() const;
+    PooledBrowser* spawn();
+    void createPendingBrowsers();
+    void createBrowser(PooledBrowser* browser);
+    void closeBrowser(PooledBrowser* browser);
+
+private:
+    CefRuntime&                                 mRuntime;
+    juce::SharedResourcePointer<PluginSettings> mSettings;
+
+    juce::ReferenceCountedArray<PooledBrowser>  mBrowsers;
+    juce::ReferenceCountedArray<PooledBrowser>  mLayers;
+    const int                                   mWarmCount;
+    const juce::int64                           mMemoryBudget;
+    const int                                   mIdleTimeoutMs;
+
+    int                                         mNumSpawned;
+    int                                         mNumReused;
+    int                                         mNumExpired;
+
+    JUCE_DECLARE_NON_COPYABLE(BrowserPool)
+};
@@ -0,0 +1,154 @@
+#include "CefMessagePump.h"
+#include <include/cef_app.h>
+
+const double CefMessagePump::sNoWork = std::numeric_limits<double>::max();
+
+CefMessagePump::CefMessagePump()
+    : mDueTime(sNoWork)
+    , mRunning(true)
+    , mInWork(false)
+    , mLatency(0.25, 400)
+    , mNumWakeUps(0)
+    , mWorkMs(0)
+    , mCreatedAt(juce::Time::getMillisecondCounterHiRes())
+{
+    startTimer(kFallbackIntervalMs);
+}
+
+CefMessagePump::~CefMessagePump()
+{
+    cancelPendingUpdate();
+    stopTimer();
+}
+
+// ----------------------------------------------------------------------------
+
+void CefMessagePump::schedule(juce::int64 delayMs)
+{
+    const double dueTime = juce::Time::getMillisecondCounterHiRes() + (double)juce::jmax<juce::int64>(0, delayMs);
+
+    // keep the earliest request, the work it gets covers the later ones
+    double current = mDueTime.load();
+    while (dueTime < current && !mDueTime.compare_exchange_weak(current, dueTime))
+    {
+    }
+    if (mRunning)
+    {
+        triggerAsyncUpdate();
+    }
+}
+
+void CefMessagePump::setRunning(bool shouldRun)
+{
+    mRunning = shouldRun;
+
+    // also drops a message posted to a message loop that has gone since
+    cancelPendingUpdate();
+    if (shouldRun)
+    {
+        startTimer(kFallbackIntervalMs);
+        triggerAsyncUpdate();
+    }
+    else
+    {
+        stopTimer();
+    }
+}
+
+bool CefMessagePump::waitPumping(juce::WaitableEvent& event, int timeoutMs)
+{
+    jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+
+    const double deadline = juce::Time::getMillisecondCounterHiRes() + timeoutMs;
+    while (!event.wait(0))
+    {
+        if (juce::Time::getMillisecondCounterHiRes() >= deadline)
+        {
+            return false;
+        }
+        CefDoMessageLoopWork();
+        juce::Thread::sleep(1);
+    }
+    return true;
+}
+
+juce::var CefMessagePump::getMetrics(MetricsSnapshot& ioLast) const
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double elapsedMs = juce::jmax(1.0, now - (ioLast.time > 0.0 ? ioLast.time : mCreatedAt));
+
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("latencyMeanMs", mLatency.getMean());
+    metrics->setProperty("latencyP99Ms", mLatency.getPercentile(0.99));
+    metrics->setProperty("latencyMaxMs", mLatency.getMax());
+    metrics->setProperty("wakeUpsPerSecond", 1000.0 * (double)(mNumWakeUps - ioLast.numWakeUps) / elapsedMs);
+    metrics->setProperty("busy", (mWorkMs - ioLast.workMs) / elapsedMs);
+
+    ioLast.time = now;
+    ioLast.numWakeUps = mNumWakeUps;
+    ioLast.workMs = mWorkMs;
+    return juce::var(metrics);
+}
+
+// ----------------------------------------------------------------------------
+
+void CefMessagePump::handleAsyncUpdate()
+{
+    scheduleNextWork();
+}
+
+void CefMessagePump::timerCallback()
+{
+    if (mDueTime.load() == sNoWork)
+    {
+        // nothing announced for a while
+        doWork();
+        return;
+    }
+    scheduleNextWork();
+}
+
+void CefMessagePump::scheduleNextWork()
+{
+    const double dueTime = mDueTime.load();
+    const double remainingMs = dueTime - juce::Time::getMillisecondCounterHiRes();
+    if (remainingMs <= 0.5)
+    {
+        doWork();
+        return;
+    }
+    startTimer(juce::jlimit(1, (int)kFallbackIntervalMs, (int)std::ceil(remainingMs)));
+}
+
+void CefMessagePump::doWork()
+{
+    if (mInWork)
+    {
+        // a nested message loop inside CEF, the outer call picks the work up
+        return;
+    }
+
+    const double start = juce::Time::getMillisecondCounterHiRes();
+    const double dueTime = mDueTime.exchange(sNoWork);
+    if (dueTime != sNoWork)
+    {
+        mLatency.add(juce::jmax(0.0, start - dueTime));
+    }
+
+    mInWork = true;
+    CefDoMessageLoopWork();
+    mInWork = false;
+
+    ++mNumWakeUps;
+    mWorkMs += juce::Time::getMillisecondCounterHiRes() - start;
+
+    if (mDueTime.load() == sNoWork)
+    {
+        startTimer(kFallbackIntervalMs);
+    }
+    else
+    {
+        // CEF asked for more while working
+        triggerAsyncUpdate();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include "AtomicHistogram.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// CEF only runs its own message loop thread on Windows, everywhere else it is
+// pumped from the JUCE message thread.
+#ifndef CEFPLUGIN_EXTERNAL_MESSAGE_PUMP
+ #define CEFPLUGIN_EXTERNAL_MESSAGE_PUMP (! JUCE_WINDOWS)
+#endif
+
+/**
+    Calls CefDoMessageLoopWork() on the JUCE message thread when CEF runs with
+    external_message_pump.
+
+    CEF announces work through OnScheduleMessagePumpWork(), schedule() turns
+    that into an async message, or a one-shot timer for delayed work, so the
+    pump sleeps while Chromium is idle instead of polling. A slow fallback
+    timer catches the rare work CEF does not announce.
+*/
+class CefMessagePump
+    : private juce::AsyncUpdater
+    , private juce::Timer
+{
+public:
+    enum
+    {
+        kFallbackIntervalMs = 100
+    };
+
+    /** The pump's cumulative counters as one reader saw them last. */
+    struct MetricsSnapshot
+    {
+        double          time = 0.0;
+        juce::int64     numWakeUps = 0;
+        double          workMs = 0.0;
+    };
+
+    CefMessagePump();
+    ~CefMessagePump();
+
+public:
+    // Any thread. A delay of 0 or less asks for work as soon as possible.
+    void schedule(juce::int64 delayMs);
+
+    // A stopped pump only records requested work and picks it
+    // up when it runs again.
+    void setRunning(bool shouldRun);
+
+    // Message thread. Pumps until the event is signalled, for waits on CEF
+    // that would otherwise block the thread CEF runs on.
+    static bool waitPumping(juce::WaitableEvent& event, int timeoutMs);
+
+    // Message thread. Wake-ups and the share of message thread time spent in
+    // CEF since ioLast, which is then advanced, and the scheduling latency
+    // over the pump's lifetime. Every reader keeps its own ioLast, the pump is
+    // shared by all instances.
+    juce::var getMetrics(MetricsSnapshot& ioLast) const;
+
+private:
+    void handleAsyncUpdate() override;
+    void timerCallback() override;
+    void scheduleNextWork();
+    void doWork();
+
+private:
+    static const double         sNoWork;
+
+    std::atomic<double>         mDueTime;       // ms counter of the earliest requested work
+    std::atomic<bool>           mRunning;
+    bool                        mInWork;
+
+    AtomicHistogram             mLatency;       // ms between due time and work
+    juce::int64                 mNumWakeUps;    // cumulative, message thread only
+    double                      mWorkMs;
+    const double                mCreatedAt;
+
+    JUCE_DECLARE_NON_COPYABLE(CefMessagePump)
+};
@@ -0,0 +1,187 @@
+#include "CefRuntime.h"
+
+CefRuntime& CefRuntime::getInstance()
+{
+    // never deleted, CEF cannot be initialised again in a process once it has
+    // been shut down
+    static CefRuntime* const sInstance = new CefRuntime();
+    return *sInstance;
+}
+
+CefRuntime::CefRuntime()
+    : juce::Thread("CEF runtime")
+    , mApp(new App())
+    , mReadiness(mInitialised.get_future().share())
+{
+    juce::SharedResourcePointer<PluginSettings> settings;
+    if (!settings->isMemoryCacheEnabled())
+    {
+        // Chromium cannot share a cache directory between processes, a second
+        // host falls back to memory
+        const juce::File directory = settings->getCacheDirectory();
+        mCacheLock = new juce::InterProcessLock("CEFPlugIn-" + juce::String::toHexString(directory.getFullPathName().hashCode64()));
+        if (directory.createDirectory() && mCacheLock->enter(0))
+        {
+            mCacheDirectory = directory;
+        }
+        else
+        {
+            CEFPLUGIN_LOG_WARNING("runtime", "cache directory in use, caching in memory: %s", directory.getFullPathName().toRawUTF8());
+            mCacheLock = nullptr;
+        }
+    }
+    mApp->setDiskCachesEnabled(!isCacheInMemory());
+
+    // without the helper, Chromium's subprocesses would be copies of the host
+    if (settings->isBrowserHelperEnabled() && getBrowserHelper().existsAsFile())
+    {
+        mBrowserHelper = getBrowserHelper();
+    }
+    mApp->setMultiProcess(isMultiProcess());
+
+#if CEFPLUGIN_EXTERNAL_MESSAGE_PUMP
+    // CEF lives on the message thread, started right after the caller returns
+    mMessagePump = new CefMessagePump();
+    mApp->setMessagePump(mMessagePump);
+    triggerAsyncUpdate();
+#else
+    startThread();
+#endif
+}
+
+void CefRuntime::setIdle(bool isIdle)
+{
+    if (mMessagePump != nullptr)
+    {
+        mMessagePump->setRunning(!isIdle);
+    }
+}
+
+bool CefRuntime::isInitialised() const
+{
+    return mReadiness.wait_for(std::chrono::seconds(0)) == std::future_status::ready && mReadiness.get();
+}
+
+juce::File CefRuntime::getBrowserHelper()
+{
+#if JUCE_WINDOWS
+    const char* helperName = "CEFPlugInHelper.exe";
+#else
+    const char* helperName = "CEFPlugInHelper";
+#endif
+    // the plugin binary, not the host
+    return juce::File::getSpecialLocation(juce::File::currentExecutableFile).getSiblingFile(helperName);
+}
+
+juce::var CefRuntime::getMessagePumpMetrics(CefMessagePump::MetricsSnapshot& ioLast) const
+{
+    return mMessagePump != nullptr ? mMessagePump->getMetrics(ioLast) : juce::var();
+}
+
+// ----------------------------------------------------------------------------
+
+void CefRuntime::run()
+{
+    // CEF runs its own UI thread, this one is only needed to start it
+    mInitialised.set_value(initialise());
+}
+
+void CefRuntime::handleAsyncUpdate()
+{
+    mInitialised.set_value(initialise());
+}
+
+bool CefRuntime::initialise()
+{
+    // init CEF
+    CefMainArgs args;
+
+    {
+        int result = CefExecuteProcess(args, mApp.get(), nullptr);
+        // checkout CefApp, derive it and set it as second parameter, for more control on
+        // command args and resources.
+        if (result >= 0) // child proccess has endend, so exit.
+        {
+            return false;
+        }
+        else if (result == -1)
+        {
+            // we are here in the father proccess.
+        }
+    }
+
+    {
+        CefSettings settings;
+
+        // CefString(&settings.resources_dir_path).FromASCII("");
+        // checkout detailed settings options:
+        // http://magpcss.org/ceforum/apidocs/projects/%28default%29/_cef_settings_t.html
+        // nearly all the settings can be set via args too.
+        if (isMultiProcess())
+        {
+            // renderer, GPU and utility processes only load what the helper needs
+            settings.single_process = false;
+            CefString(&settings.browser_subprocess_path).FromString(mBrowserHelper.getFullPathName().toStdString());
+        }
+        else
+        {
+            settings.single_process = true;
+        }
+#if CEFPLUGIN_EXTERNAL_MESSAGE_PUMP
+        // CEF asks for work through App::OnScheduleMessagePumpWork()
+        settings.external_message_pump = true;
+        settings.multi_threaded_message_loop = false;
+#else
+        settings.multi_threaded_message_loop = true; // not supported, except windows
+#endif
+        // settings.single_process = true; // not supported, except windows
+        // settings.remote_debugging_port = 8090;
+        // the global context stays in memory, browsers use mRequestContext
+        settings.persist_session_cookies = false;
+        if (!isCacheInMemory())
+        {
+            // keeps Chromium's own files out of the host's working directory
+            CefString(&settings.user_data_dir).FromString(mCacheDirectory.getChildFile("UserData").getFullPathName().toStdString());
+        }
+        // CefString(&settings.log_file).FromASCII("");
+        // settings.log_severity = LOGSEVERITY_DEFAULT;
+
+        // CefInitialize creates a sub-proccess and executes the same executeable,
+        // as calling CefInitialize, if not set different in settings.browser_subprocess_path
+        // if you create an extra program just for the childproccess you only have to call CefExecuteProcess(...) in it.
+        {
+            const StartupTracer::ScopedSpan span("CefInitialize");
+            if (!CefInitialize(args, settings, mApp.get(), nullptr))
+            {
+                CEFPLUGIN_LOG_ERROR("runtime", "CefInitialize failed");
+                return false;
+            }
+        }
+        StartupTracer::beginChromiumTracing(juce::SharedResourcePointer<PluginSettings>()->getStartupTraceFile());
+    }
+
+#if JUCE_WINDOWS
+    // CEF's threads run until the process exits, the host must not unload the
+    // plugin and libcef under them
+    HMODULE module = nullptr;
+    GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                       (LPCWSTR)&CefRuntime::getInstance, &module);
+#endif
+
+    // one context for every browser in the process, an empty path keeps it in memory
+    CefRequestContextSettings contextSettings;
+    if (!isCacheInMemory())
+    {
+        CefString(&contextSettings.cache_path).FromString(mCacheDirectory.getChildFile("Browser").getFullPathName().toStdString());
+        contextSettings.persist_session_cookies = true;
+    }
+    mRequestContext = CefRequestContext::CreateContext(contextSettings, nullptr);
+
+    // the UI is served from memory, see UiSchemeHandlerFactory
+    const bool schemeRegistered = UiSchemeHandlerFactory::registerFactory(mRequestContext);
+    jassert(schemeRegistered);
+    juce::ignoreUnused(schemeRegistered);
+
+    CEFPLUGIN_LOG_INFO("runtime", "CEF initialised multiProcess=%d memoryCache=%d", (int)isMultiProcess(), (int)isCacheInMemory());
+    return true;
+}
@@ -0,0 +1,320 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <include/cef_app.h>
+#include <include/cef_request_context.h>
+#include "CefMessagePump.h"
+#include "PluginLog.h"
+#include "PluginSettings.h"
+#include "StartupTracer.h"
+#include "RendererApp.h"
+#include "SharedCanvas.h"
+#include "UiSchemeHandler.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// Process-wide CefApp of the plugin. When everything runs in one process the
+// renderer side lives here too, and window.parameters resolves the processor of
+// the browser whose V8 context is currently running. With the browser helper,
+// BrowserClient relays the parameters instead. Pages in this process also get
+// window.createSharedCanvas(), see SharedCanvas.
+class App
+    : public RendererApp
+    , public CefBrowserProcessHandler
+{
+public:
+    App()
+        : mDiskCachesEnabled(true)
+        , mMultiProcess(false)
+        , mMessagePump(nullptr)
+    {
+    }
+
+public:
+    // Must be set before CEF is initialised.
+    void setDiskCachesEnabled(bool enabled)
+    {
+        mDiskCachesEnabled = enabled;
+    }
+
+    // Must be set before CEF is initialised.
+    void setMultiProcess(bool multiProcess)
+    {
+        mMultiProcess = multiProcess;
+    }
+
+    bool isMultiProcess() const
+    {
+        return mMultiProcess;
+    }
+
+    // With an external message pump, receives CEF's work requests.
+    void setMessagePump(CefMessagePump* inMessagePump)
+    {
+        mMessagePump = inMessagePump;
+    }
+
+    void registerBrowser(int browserId, juce::AudioProcessor* inAudioProcessor)
+    {
+        const juce::ScopedLock sl(mLock);
+        mProcessors.set(browserId, inAudioProcessor);
+    }
+
+    void unregisterBrowser(int browserId)
+    {
+        // getParameter()/setParameter() hold the lock while using the
+        // processor, so it is safe to destroy it once this returns.
+        const juce::ScopedLock sl(mLock);
+        mProcessors.remove(browserId);
+    }
+
+    // The canvas the main frame of a browser created last, if any. Any thread.
+    SharedCanvas::Ptr getSharedCanvas(int browserId) const
+    {
+        const juce::SpinLock::ScopedLockType sl(mCanvasLock);
+        return mCanvases[browserId];
+    }
+
+public: // CefApp
+    virtual CefRefPtr<CefBrowserProcessHandler> GetBrowserProcessHandler() override
+    {
+        return this;
+    }
+
+    virtual void OnBeforeCommandLineProcessing(const CefString& process_type,
+                                               CefRefPtr<CefCommandLine> command_line) override
+    {
+        if (!mDiskCachesEnabled)
+        {
+            // Chromium would write GPUCache into the host's working directory
+            command_line->AppendSwitch("disable-gpu-shader-disk-cache");
+        }
+        if (mMultiProcess)
+        {
+            // every plugin page comes from the same origin, one renderer is enough
+            command_line->AppendSwitchWithValue("renderer-process-limit", "1");
+        }
+    }
+
+public: // CefRenderProcessHandler
+    virtual void OnWebKitInitialized() override
+    {
+        RendererApp::OnWebKitInitialized();
+
+        // only ever registered in this process, the helper has no App
+        CefRegisterExtension("v8/cefplugin-canvas",
+                             "(function () {"
+                             "    native function CreateSharedCanvas(width, height);"
+                             "    if (window === window.top) {"
+                             "        Object.defineProperty(window, 'createSharedCanvas', {"
+                             "            value: function (width, height) { return CreateSharedCanvas(width, height); },"
+                             "            writable: true, enumerable: true"
+                             "        });"
+                             "    }"
+                             "})();",
+                             this);
+    }
+
+    virtual void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefV8Context> context) override
+    {
+        // only seen here in a single process, the helper's renderer is in Chromium's trace
+        StartupTracer::addInstant("OnContextCreated", browser->GetIdentifier());
+        if (frame->IsMain())
+        {
+            // the new page creates its own
+            setSharedCanvas(browser->GetIdentifier(), nullptr);
+        }
+        RendererApp::OnContextCreated(browser, frame, context);
+    }
+
+    virtual void OnBrowserDestroyed(CefRefPtr<CefBrowser> browser) override
+    {
+        setSharedCanvas(browser->GetIdentifier(), nullptr);
+        RendererApp::OnBrowserDestroyed(browser);
+    }
+
+public: // CefV8Handler
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception) override
+    {
+        if (name != "CreateSharedCanvas")
+        {
+            return RendererApp::Execute(name, object, arguments, retval, exception);
+        }
+
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        const int width = arguments.size() == 2 && arguments[0]->IsInt() ? arguments[0]->GetIntValue() : 0;
+        const int height = arguments.size() == 2 && arguments[1]->IsInt() ? arguments[1]->GetIntValue() : 0;
+        if (width < 1 || width > SharedCanvas::kMaxSize || height < 1 || height > SharedCanvas::kMaxSize)
+        {
+            exception = "createSharedCanvas() takes a width and height of 1 to 2048 pixels";
+            return true;
+        }
+        if (context == nullptr || !context->GetFrame()->IsMain())
+        {
+            exception = "createSharedCanvas() is only available to the main frame";
+            return true;
+        }
+
+        // replaces the page's previous canvas, whose buffer stays valid for V8
+        SharedCanvas::Ptr canvas = new SharedCanvas(width, height);
+        setSharedCanvas(context->GetBrowser()->GetIdentifier(), canvas);
+        retval = canvas->createV8Object();
+        return true;
+    }
+
+public: // CefBrowserProcessHandler
+    virtual void OnScheduleMessagePumpWork(int64 delay_ms) override
+    {
+        // any thread
+        if (CefMessagePump* messagePump = mMessagePump)
+        {
+            messagePump->schedule(delay_ms);
+        }
+    }
+
+protected: // RendererApp
+    bool getParameter(CefRefPtr<CefBrowser> browser, int index, double& outValue) override
+    {
+        const juce::ScopedLock sl(mLock);
+        if (juce::AudioProcessorParameter* param = findParameter(browser, index))
+        {
+            outValue = param->getValue();
+            return true;
+        }
+        return false;
+    }
+
+    bool setParameter(CefRefPtr<CefBrowser> browser, int index, double value) override
+    {
+        const juce::ScopedLock sl(mLock);
+        if (juce::AudioProcessorParameter* param = findParameter(browser, index))
+        {
+            param->setValueNotifyingHost((float)value);
+            return true;
+        }
+        return false;
+    }
+
+    void getParameterNames(CefRefPtr<CefBrowser> browser, juce::StringArray& outNames) override
+    {
+        const juce::ScopedLock sl(mLock);
+        if (juce::AudioProcessor* processor = mProcessors[browser->GetIdentifier()])
+        {
+            for (const auto& param : processor->getParameters())
+            {
+                outNames.add(param->getName(256));
+            }
+        }
+    }
+
+private:
+    void setSharedCanvas(int browserId, SharedCanvas* canvas)
+    {
+        // a replaced canvas may be freed here, not under the lock
+        SharedCanvas::Ptr previous;
+        const juce::SpinLock::ScopedLockType sl(mCanvasLock);
+        previous = mCanvases[browserId];
+        if (canvas != nullptr)
+        {
+            mCanvases.set(browserId, canvas);
+        }
+        else
+        {
+            mCanvases.remove(browserId);
+        }
+    }
+
+    // Must be called with mLock held.
+    juce::AudioProcessorParameter* findParameter(CefRefPtr<CefBrowser> browser, int index)
+    {
+        juce::AudioProcessor* processor = mProcessors[browser->GetIdentifier()];
+        return processor != nullptr ? processor->getParameters()[index] : nullptr;
+    }
+
+private:
+    bool                                            mDiskCachesEnabled;
+    bool                                            mMultiProcess;
+    std::atomic<CefMessagePump*>                    mMessagePump;
+    juce::CriticalSection                           mLock;
+    juce::HashMap<int, juce::AudioProcessor*>       mProcessors;
+    juce::HashMap<int, SharedCanvas::Ptr>           mCanvases;
+    juce::SpinLock                                  mCanvasLock;
+
+public:
+    IMPLEMENT_REFCOUNTING(App);
+};
+
+/**
+    Process-wide CEF runtime shared by every plugin instance.
+
+    getInstance() creates it and initialises CEF the first time an instance
+    needs it. It then stays for the rest of the process: CEF cannot be
+    initialised again once it has been shut down, so a host that closes every
+    instance and opens a new one would get no UI. Without instances the runtime
+    only idles, the pool has closed every browser by then. Each instance then
+    only creates its own browser.
+
+    Start-up runs on a dedicated thread so it never blocks the host while it
+    constructs or scans the plugin, getReadiness() tells when it is done. With
+    an external message pump CEF lives on the message thread instead, started
+    from an async message.
+
+    Every browser uses the same request context, so instances share one cache
+    and cookie store. It lives in the cache directory from PluginSettings, or
+    purely in memory when the memory cache is enabled there or when another
+    process already uses the directory.
+*/
+class CefRuntime
+    : private juce::Thread
+    , private juce::AsyncUpdater
+{
+public:
+    static CefRuntime& getInstance();
+
+public:
+    // Becomes true once CEF is up, false if it could not start.
+    std::shared_future<bool> getReadiness() const   { return mReadiness; }
+    bool isInitialised() const;
+
+    CefRefPtr<App> getApp() const                   { return mApp; }
+
+    // Only valid once the runtime is initialised.
+    CefRefPtr<CefRequestContext> getRequestContext() const  { return mRequestContext; }
+    bool isCacheInMemory() const                    { return mCacheDirectory == juce::File(); }
+
+    // Void without an external message pump, see CefMessagePump::getMetrics().
+    juce::var getMessagePumpMetrics(CefMessagePump::MetricsSnapshot& ioLast) const;
+
+    // Stops the message pump while no instance needs CEF, the host may shut
+    // JUCE's message loop down until the next one comes.
+    void setIdle(bool isIdle);
+
+    // Installed next to the plugin binary.
+    static juce::File getBrowserHelper();
+    bool isMultiProcess() const                     { return mBrowserHelper != juce::File(); }
+
+private:
+    CefRuntime();
+
+    void run() override;
+    void handleAsyncUpdate() override;
+    bool initialise();
+
+private:
+    CefRefPtr<App>              mApp;
+    juce::ScopedPointer<CefMessagePump> mMessagePump;
+    juce::File                  mCacheDirectory;    // empty when caching in memory
+    juce::File                  mBrowserHelper;     // empty when running in a single process
+    juce::ScopedPointer<juce::InterProcessLock> mCacheLock;
+    CefRefPtr<CefRequestContext> mRequestContext;
+    std::promise<bool>          mInitialised;
+    std::shared_future<bool>    mReadiness;
+
+    JUCE_DECLARE_NON_COPYABLE(CefRuntime)
+};
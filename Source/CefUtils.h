@@ -0,0 +1,28 @@
+#pragma once
+
+#include <functional>
+#include <include/cef_task.h>
+
+/**
+    Runs a function as a CefTask, e.g. to hop onto one of CEF's threads:
+        CefPostTask(TID_UI, new FunctionTask([]() { ... }));
+*/
+class FunctionTask
+    : public CefTask
+{
+public:
+    FunctionTask(std::function<void()> inFunction)
+        : mFunction(inFunction)
+    {
+    }
+
+    void Execute() override
+    {
+        mFunction();
+    }
+
+private:
+    std::function<void()> mFunction;
+
+    IMPLEMENT_REFCOUNTING(FunctionTask);
+};
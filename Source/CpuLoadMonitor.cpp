@@ -0,0 +1,91 @@
+#include "CpuLoadMonitor.h"
+
+CpuLoadMonitor::CpuLoadMonitor()
+    : mSampleRate(44100.0)
+    , mMaximumBlockSize(0)
+    , mLoad(1.0, kMaxLoadPercent)
+    , mNumOverruns(0)
+    , mTicksToSeconds(1.0 / (double)juce::Time::getHighResolutionTicksPerSecond())
+{
+    juce::zeromem(mOverruns, sizeof(mOverruns));
+}
+
+// ----------------------------------------------------------------------------
+
+void CpuLoadMonitor::prepare(double sampleRate, int maximumBlockSize)
+{
+    mSampleRate = sampleRate > 0 ? sampleRate : 44100.0;
+    mMaximumBlockSize = maximumBlockSize;
+    reset();
+}
+
+void CpuLoadMonitor::reset()
+{
+    mLoad.reset();
+    mNumOverruns = 0;
+}
+
+void CpuLoadMonitor::finishBlock(juce::int64 startTicks, int numSamples)
+{
+    if (numSamples <= 0)
+    {
+        return;
+    }
+
+    const juce::int64 endTicks = juce::Time::getHighResolutionTicks();
+    const double elapsed = (double)(endTicks - startTicks) * mTicksToSeconds;
+    const double budget = (double)numSamples / mSampleRate.load(std::memory_order_relaxed);
+    const double loadPercent = 100.0 * elapsed / budget;
+
+    mLoad.add(loadPercent);
+
+    if (loadPercent > 100.0)
+    {
+        const juce::int64 index = mNumOverruns.fetch_add(1, std::memory_order_relaxed);
+        OverrunRecord& record = mOverruns[index % kNumOverrunRecords];
+        record.timeMs = (double)endTicks * mTicksToSeconds * 1000.0;
+        record.loadPercent = (float)loadPercent;
+        record.numSamples = numSamples;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+juce::var CpuLoadMonitor::getMetrics() const
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("sampleRate", mSampleRate.load());
+    metrics->setProperty("blockSize", mMaximumBlockSize.load());
+    metrics->setProperty("blocks", mLoad.getCount());
+    metrics->setProperty("loadPercent", mLoad.getMean());
+    metrics->setProperty("p99Percent", mLoad.getPercentile(0.99));
+    metrics->setProperty("worstPercent", mLoad.getMax());
+    metrics->setProperty("overruns", getNumOverruns());
+    return juce::var(metrics);
+}
+
+bool CpuLoadMonitor::exportLog(const juce::File& file) const
+{
+    juce::String text;
+    text << "sample rate: " << mSampleRate.load() << "\n"
+         << "block size: " << mMaximumBlockSize.load() << "\n"
+         << "blocks: " << mLoad.getCount() << "\n"
+         << "load: " << mLoad.getMean() << " %\n"
+         << "p50: " << mLoad.getPercentile(0.5) << " %\n"
+         << "p99: " << mLoad.getPercentile(0.99) << " %\n"
+         << "worst: " << mLoad.getMax() << " %\n"
+         << "overruns: " << getNumOverruns() << "\n\n"
+         << "time_ms,load_percent,num_samples\n";
+
+    // the audio thread may still be writing, a torn record only costs a line
+    const juce::int64 numOverruns = getNumOverruns();
+    const juce::int64 first = std::max<juce::int64>(0, numOverruns - kNumOverrunRecords);
+    for (juce::int64 i = first; i < numOverruns; ++i)
+    {
+        const OverrunRecord& record = mOverruns[i % kNumOverrunRecords];
+        text << juce::String(record.timeMs, 3) << "," << juce::String(record.loadPercent, 1)
+             << "," << record.numSamples << "\n";
+    }
+
+    return file.replaceWithText(text);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include "AtomicHistogram.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Times every processBlock() call against its real-time budget, i.e. the
+    duration of the samples it has to produce at the prepared sample rate.
+
+    Loads are kept in a lock-free histogram in percent of the budget, blocks
+    that took longer than their budget are counted as deadline overruns and
+    remembered in a small preallocated ring so they can be exported later.
+*/
+class CpuLoadMonitor
+{
+public:
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer(CpuLoadMonitor& inMonitor, int inNumSamples)
+            : mMonitor(inMonitor)
+            , mNumSamples(inNumSamples)
+            , mStartTicks(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedBlockTimer()
+        {
+            mMonitor.finishBlock(mStartTicks, mNumSamples);
+        }
+
+    private:
+        CpuLoadMonitor& mMonitor;
+        const int       mNumSamples;
+        const juce::int64 mStartTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlockTimer)
+    };
+
+    enum
+    {
+        kMaxLoadPercent = 400,
+        kNumOverrunRecords = 256
+    };
+
+    CpuLoadMonitor();
+
+public:
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    // Audio thread only, use ScopedBlockTimer.
+    void finishBlock(juce::int64 startTicks, int numSamples);
+
+public:
+    juce::int64 getNumOverruns() const { return mNumOverruns.load(std::memory_order_relaxed); }
+
+    // load %, p99 and worst case since the last reset()
+    juce::var getMetrics() const;
+
+    // Writes the summary and the most recent overruns as plain text.
+    bool exportLog(const juce::File& file) const;
+
+private:
+    struct OverrunRecord
+    {
+        double  timeMs;
+        float   loadPercent;
+        int     numSamples;
+    };
+
+    std::atomic<double>         mSampleRate;
+    std::atomic<int>            mMaximumBlockSize;
+    AtomicHistogram             mLoad;
+    std::atomic<juce::int64>    mNumOverruns;
+    OverrunRecord               mOverruns[kNumOverrunRecords];
+    double                      mTicksToSeconds;
+
+    JUCE_DECLARE_NON_COPYABLE(CpuLoadMonitor)
+};
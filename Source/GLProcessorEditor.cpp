@@ -1,11 +1,28 @@
 #include "GLProcessorEditor.h"
+#include "GainPlugin.h"
 
-GLProcessorEditor::GLProcessorEditor (juce::AudioProcessor& parent, BrowserManager *inBrowserManager)
+GLProcessorEditor::GLProcessorEditor (GainPlugin& parent)
     : AudioProcessorEditor (parent)
     , noParameterLabel ("noparam", "No parameters available")
-    , mBrowserManager(inBrowserManager)
-    , mPixels(new uint32[1920 * 1080])
+    , mBrowserManager(parent.getBrowserManager())
+    , mInputQueue(*mBrowserManager)
+    , mBrowserShown(false)
+    , mHasSnapshot(false)
+    , mOpenedAt(juce::Time::getMillisecondCounterHiRes())
+    , mFrameCountAtOpen(0)
+    , mSnapshotFrameShown(false)
+    , mLiveFrameShown(false)
+    , mFirstRenderTraced(false)
+    , mConfiguredRenderScale(juce::SharedResourcePointer<PluginSettings>()->getRenderScale())
+    , mRenderScaleChangedAt(0.0)
+    , mWaveform(&parent.getWaveform())
+    , mLoadMonitor(&parent.getLoadMonitor())
+    , mTimerTicks(0)
+    , mDrawsOverlays(false)
+    , mViewScale(1.0f)
+    , mWidgetRenderer(mWaveform)
 {
+    StartupTracer::editorOpened();
     addKeyListener(this);
     setWantsKeyboardFocus(true);
 
@@ -54,16 +71,41 @@ GLProcessorEditor::GLProcessorEditor (juce::AudioProcessor& parent, BrowserManag
     mOpenGLContext.attachTo(*this);
     mOpenGLContext.setContinuousRepainting(false);
     
+    // a preloaded browser is borrowed from the pool, a native placeholder is
+    // painted until it is there
+    mBrowserManager->start();
+    mBrowserReady = mBrowserManager->getReadiness();
+
+    // a reopened editor shows the last frame it had until the browser paints again
     mRenderHandler = mBrowserManager->getRenderHandler();
+    mHasSnapshot = mRenderHandler->hasSnapshot();
+    mFrameCountAtOpen = mRenderHandler->getFrameCount();
+    if (mConfiguredRenderScale > 0.0f)
+    {
+        setRenderScale(mConfiguredRenderScale);
+    }
     mRenderHandler->setOpenGLContext(&mOpenGLContext);
+    mOpenGLContext.triggerRepaint();
 }
 
 GLProcessorEditor::~GLProcessorEditor()
 {
+    stopTimer();
+    mAnalysisJobs.cancelAll();
+
+    // the GL thread stops before the browsers go back to the pool
+    mOpenGLContext.detach();
+
     //mBrowserClient->GetBrower()->GetHost()->CloseBrowser(false);
     mRenderHandler->setOpenGLContext(nullptr);
+    for (int i = 0; i < mBrowserManager->getNumLayers(); ++i)
+    {
+        mBrowserManager->getLayerRenderHandler(i)->setOpenGLContext(nullptr);
+    }
+    mRenderHandler->takeSnapshot();
+    mBrowserManager->setBinaryListener(nullptr);
+    mBrowserManager->stop();
     removeKeyListener(this);
-    free(mPixels);
 }
 
 // ----------------------------------------------------------------------------
@@ -97,107 +139,50 @@ void GLProcessorEditor::resized()
 
 void GLProcessorEditor::paint (juce::Graphics& g)
 {
-    //g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+    if (mBrowserShown || mHasSnapshot)
+    {
+        return;
+    }
+
+    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+    g.setColour (juce::Colours::white.withAlpha (0.6f));
+    g.setFont (juce::Font (16.0f, juce::Font::italic));
+
+    const bool failed = mBrowserReady.wait_for(std::chrono::seconds(0)) == std::future_status::ready && !mBrowserReady.get();
+    g.drawText (failed ? "User interface unavailable" : "Loading...", getLocalBounds(), juce::Justification::centred);
 }
 
 // ----------------------------------------------------------------------------
 
 void GLProcessorEditor::mouseMove(const juce::MouseEvent& event)
 {
-    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
-    if (browser == nullptr)
-    {
-        return;
-    }
-    CefMouseEvent cefEvent;
-    cefEvent.x = event.getPosition().getX();
-    cefEvent.y = event.getPosition().getY();
-    browser->GetHost()->SendMouseMoveEvent(cefEvent, false);
+    mInputQueue.mouseMove(event);
 }
 
 void GLProcessorEditor::mouseDown(const juce::MouseEvent& event)
 {
-    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
-    if (browser == nullptr)
-    {
-        return;
-    }
-    CefMouseEvent cefEvent;
-    cefEvent.x = event.getPosition().getX();
-    cefEvent.y = event.getPosition().getY();
-
-    cef_mouse_button_type_t type;
-    if (event.mods.isLeftButtonDown())
-    {
-        type = MBT_LEFT;
-    }
-    else if (event.mods.isMiddleButtonDown())
-    {
-        type = MBT_MIDDLE;
-    }
-    else if (event.mods.isRightButtonDown())
-    {
-        type = MBT_RIGHT;
-    }
-    browser->GetHost()->SendMouseClickEvent(cefEvent, type, false, event.getNumberOfClicks());
+    mInputQueue.mouseButton(event, false);
 }
 
 void GLProcessorEditor::mouseDrag(const juce::MouseEvent& event)
 {
-    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
-    if (browser == nullptr)
-    {
-        return;
-    }
-    CefMouseEvent cefEvent;
-    cefEvent.x = event.getPosition().getX();
-    cefEvent.y = event.getPosition().getY();
-    browser->GetHost()->SendMouseMoveEvent(cefEvent, false);
+    mInputQueue.mouseMove(event);
 }
 
 void GLProcessorEditor::mouseUp(const juce::MouseEvent& event)
 {
-    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
-    if (browser == nullptr)
-    {
-        return;
-    }
-    CefMouseEvent cefEvent;
-    cefEvent.x = event.getPosition().getX();
-    cefEvent.y = event.getPosition().getY();
-    
-    cef_mouse_button_type_t type;
-    if (event.mods.isLeftButtonDown())
-    {
-        type = MBT_LEFT;
-    }
-    else if (event.mods.isMiddleButtonDown())
-    {
-        type = MBT_MIDDLE;
-    }
-    else if (event.mods.isRightButtonDown())
-    {
-        type = MBT_RIGHT;
-    }
-    browser->GetHost()->SendMouseClickEvent(cefEvent, type, true, event.getNumberOfClicks());
+    mInputQueue.mouseButton(event, true);
+}
+
+void GLProcessorEditor::mouseExit(const juce::MouseEvent& event)
+{
+    mInputQueue.mouseExit(event);
 }
 
 void GLProcessorEditor::mouseWheelMove(const juce::MouseEvent& event,
                                        const juce::MouseWheelDetails& wheel)
 {
-    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
-    if (browser == nullptr)
-    {
-        return;
-    }
-
-    CefMouseEvent cefEvent;
-    cefEvent.x = event.getPosition().getX();
-    cefEvent.y = event.getPosition().getY();
-
-    int deltaY = static_cast<int>(wheel.deltaY * 100.f);
-
-    //browser->GetHost()->SendMouseWheelEvent(cefEvent, 0, deltaY);
+    mInputQueue.mouseWheel(event, wheel);
 }
 
 // ----------------------------------------------------------------------------
@@ -205,12 +190,35 @@ void GLProcessorEditor::mouseWheelMove(const juce::MouseEvent& event,
 bool GLProcessorEditor::keyPressed(const juce::KeyPress& key,
                                    juce::Component* originatingComponent)
 {
+    if (key == juce::KeyPress('t', juce::ModifierKeys::ctrlModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        StartupTracer::exportTrace(StartupTracer::getDefaultTraceFile());
+        return true;
+    }
+    if (key == juce::KeyPress('l', juce::ModifierKeys::ctrlModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        startLatencyBenchmark(kLatencyBenchmarkSamples);
+        return true;
+    }
+    if (key == juce::KeyPress('b', juce::ModifierKeys::ctrlModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        startBinaryBenchmark();
+        return true;
+    }
+
     CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
     if (browser == nullptr)
     {
         return false;
     }
 
+    if (key == juce::KeyPress('r', juce::ModifierKeys::ctrlModifier | juce::ModifierKeys::shiftModifier, 0))
+    {
+        // the page reports back through nativeRpc, see ui.js
+        browser->GetMainFrame()->ExecuteJavaScript("window.runRpcBenchmark && window.runRpcBenchmark(" + juce::String(kRpcBenchmarkCalls).toStdString() + ");", "", 0);
+        return true;
+    }
+
     CefKeyEvent cefKey;
     cefKey.type = KEYEVENT_CHAR;
     cefKey.modifiers = 0;
@@ -248,7 +256,46 @@ void GLProcessorEditor::sliderDragEnded (juce::Slider* slider)
 
 void GLProcessorEditor::timerCallback()
 {
-    //CefDoMessageLoopWork();
+    if (!mBrowserShown && mBrowserReady.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        mBrowserShown = mBrowserReady.get();
+        resized();
+        repaint();
+
+        // unattended runs, e.g. in CI
+        const int numBenchmarkSamples = juce::SharedResourcePointer<PluginSettings>()->getLatencyBenchmarkSamples();
+        if (mBrowserShown && numBenchmarkSamples > 0)
+        {
+            startLatencyBenchmark(numBenchmarkSamples);
+        }
+    }
+
+    mBrowserManager->syncParameters();
+    updateRenderScale();
+
+    // native widgets and the shared canvas change without Chromium painting
+    const bool drawsOverlays = mBrowserShown && (mBrowserManager->hasNativeWidgets() || mBrowserManager->getSharedCanvas() != nullptr);
+    if (drawsOverlays != mDrawsOverlays)
+    {
+        mDrawsOverlays = drawsOverlays;
+        mOpenGLContext.setContinuousRepainting(drawsOverlays);
+    }
+
+    // while native widgets are drawn the GL thread folds the envelopes every
+    // frame, otherwise the shared pool does, one job in flight at a time
+    mAnalysisJobs.setFocused(hasKeyboardFocus(true));
+    const bool drawsWidgets = mDrawsOverlays && mBrowserManager->hasNativeWidgets();
+    if (mWaveform != nullptr && !drawsWidgets && mAnalysisJobs.getNumPending() == 0)
+    {
+        WaveformPyramid* waveform = mWaveform;
+        mAnalysisJobs.submit([waveform]() { waveform->update(); });
+    }
+
+    if (++mTimerTicks % kMetricsIntervalTicks == 0)
+    {
+        publishMetrics();
+    }
+
     //const juce::OwnedArray<juce::AudioProcessorParameter>& params = getAudioProcessor()->getParameters();
     //for (int i = 0; i < params.size(); ++i)
     //{
@@ -260,6 +307,108 @@ void GLProcessorEditor::timerCallback()
     //}
 }
 
+void GLProcessorEditor::publishMetrics()
+{
+    CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser();
+    if (browser == nullptr)
+    {
+        return;
+    }
+
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("audioLoad", mLoadMonitor->getMetrics());
+    metrics->setProperty("analysisPool", mAnalysisPool->getMetrics(mAnalysisMetrics));
+    metrics->setProperty("browserPool", mBrowserManager->getPoolMetrics());
+    metrics->setProperty("editorOpen", mBrowserManager->getEditorOpenMetrics());
+    metrics->setProperty("input", mInputQueue.getMetrics());
+    metrics->setProperty("inputLatency", mBrowserManager->getInputLatencyMetrics());
+    metrics->setProperty("binaryChannel", mBrowserManager->getBinaryChannelMetrics());
+    metrics->setProperty("rpc", mBrowserManager->getRpcMetrics());
+    metrics->setProperty("messagePump", mBrowserManager->getMessagePumpMetrics());
+
+    const juce::String json = juce::JSON::toString(juce::var(metrics), true);
+    const juce::String script = "if (window.onPluginMetrics) window.onPluginMetrics(" + json + ");";
+    browser->GetMainFrame()->ExecuteJavaScript(script.toStdString(), "", 0);
+}
+
+int GLProcessorEditor::addBrowserLayer(const juce::String& url, juce::Rectangle<int> bounds, int frameRate)
+{
+    const int index = mBrowserManager->addLayer(url, bounds, frameRate);
+    mBrowserManager->getLayerRenderHandler(index)->setOpenGLContext(&mOpenGLContext);
+    return index;
+}
+
+void GLProcessorEditor::startLatencyBenchmark(int numSamples)
+{
+    const juce::File resultFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                                      .getChildFile("CEFPlugIn")
+                                      .getChildFile("latency-benchmark.json");
+    mInputQueue.startLatencyBenchmark(getLocalBounds(), numSamples, resultFile);
+}
+
+void GLProcessorEditor::startBinaryBenchmark()
+{
+    // the page echoes the payload, see ui.js
+    juce::MemoryBlock payload(kBinaryBenchmarkBytes);
+    juce::Random random;
+    for (size_t i = 0; i < payload.getSize(); i += 4)
+    {
+        *reinterpret_cast<juce::int32*>(static_cast<char*>(payload.getData()) + i) = random.nextInt();
+    }
+
+    const double sentAt = juce::Time::getMillisecondCounterHiRes();
+    mBrowserManager->setBinaryListener([sentAt](const juce::String& topic, const juce::MemoryBlock& data)
+    {
+        if (topic != "echo")
+        {
+            return;
+        }
+        const double ms = juce::Time::getMillisecondCounterHiRes() - sentAt;
+        CEFPLUGIN_LOG_INFO("binary", "echo of %d bytes in %.1f ms, %.1f MB/s both ways",
+                           (int)data.getSize(), ms, 2.0 * (double)data.getSize() / (1024.0 * 1024.0) / (ms / 1000.0));
+    });
+    mBrowserManager->sendBinary("echo", payload.getData(), payload.getSize());
+}
+
+void GLProcessorEditor::updateRenderScale()
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    if (mConfiguredRenderScale > 0.0f || now - mRenderScaleChangedAt < kRenderScaleHoldMs)
+    {
+        return;
+    }
+
+    // drop the scale while Chromium cannot keep up, back to full once it rests
+    const float scale = mRenderHandler->getRenderScale();
+    if (mRenderHandler->getMsSinceLastPaint() > kRenderScaleIdleMs)
+    {
+        setRenderScale(1.0f);
+    }
+    else if (mRenderHandler->getFrameTimeMs() > 1.25 * 1000.0 / RenderHandler::kFrameRate)
+    {
+        setRenderScale(scale * 0.8f);
+    }
+}
+
+void GLProcessorEditor::setRenderScale(float scale)
+{
+    const float previous = mRenderHandler->getRenderScale();
+    mRenderHandler->setRenderScale(scale);
+    if (mRenderHandler->getRenderScale() == previous)
+    {
+        return;
+    }
+
+    mRenderScaleChangedAt = juce::Time::getMillisecondCounterHiRes();
+    CEFPLUGIN_LOG_DEBUG("editor", "render scale %.2f", mRenderHandler->getRenderScale());
+
+    if (CefRefPtr<CefBrowser> browser = mBrowserManager->getBrowser())
+    {
+        browser->GetHost()->NotifyScreenInfoChanged();
+        browser->GetHost()->WasResized();
+    }
+}
+
 juce::AudioProcessorParameter* GLProcessorEditor::getParameterForSlider (juce::Slider* slider)
 {
     const juce::OwnedArray<juce::AudioProcessorParameter>& params = getAudioProcessor()->getParameters();
@@ -273,35 +422,132 @@ void GLProcessorEditor::renderOpenGL()
     jassert(juce::OpenGLHelpers::isContextActive());
     //juce::OpenGLHelpers::clear(juce::Colours::red);
 
+    if (!mFirstRenderTraced)
+    {
+        mFirstRenderTraced = true;
+        StartupTracer::addInstant("FirstRenderOpenGL");
+    }
+
+    mCompositor.begin(getWidth(), getHeight());
+
+    // nothing the browser painted before the editor opened belongs on screen
+    const bool hasLiveFrame = mBrowserShown && mRenderHandler->getFrameCount() != mFrameCountAtOpen;
+    if (!hasLiveFrame)
+    {
+        if (!mCompositor.hasFrame(LayerCompositor::kViewLayer))
+        {
+            mRenderHandler->readSnapshot([this](const RenderHandler::Snapshot& snapshot)
+            {
+                mCompositor.upload(LayerCompositor::kViewLayer, snapshot.pixels, snapshot.width, snapshot.height, mFrameCountAtOpen);
+                mViewScale = snapshot.scale;
+            });
+        }
+
+        // otherwise the placeholder is drawn by paint()
+        if (mCompositor.hasFrame(LayerCompositor::kViewLayer))
+        {
+            drawView();
+            if (!mSnapshotFrameShown)
+            {
+                mSnapshotFrameShown = true;
+                StartupTracer::addInstant("FirstSnapshotFrame");
+                mBrowserManager->getSnapshotFrameLatency().add(juce::Time::getMillisecondCounterHiRes() - mOpenedAt);
+            }
+        }
+        return;
+    }
+
+    if (!mLiveFrameShown)
+    {
+        mLiveFrameShown = true;
+        StartupTracer::addInstant("FirstLiveFrame");
+        StartupTracer::startupComplete();
+        mBrowserManager->getLiveFrameLatency().add(juce::Time::getMillisecondCounterHiRes() - mOpenedAt);
+    }
+
+    // at least this frame goes on screen, only a new one is uploaded
+    const juce::uint32 frameCount = mRenderHandler->getFrameCount();
+    if (frameCount != mCompositor.getFrameNumber(LayerCompositor::kViewLayer))
+    {
+        mRenderHandler->readFrame([this, frameCount](const uint32* pixels, int width, int height, float scale)
+        {
+            mCompositor.upload(LayerCompositor::kViewLayer, pixels, width, height, frameCount);
+            mViewScale = scale;
+        });
+    }
+    drawView();
 
-    int bufferWidth, bufferHeight;
-    uint32 *pBuffer = mRenderHandler->getBuffer(bufferWidth, bufferHeight);
-    uint32 *pBufferPtr = pBuffer;
+    // extra browsers, each uploaded at its own rate
+    for (int i = 0; i < mBrowserManager->getNumLayers(); ++i)
+    {
+        CefRefPtr<RenderHandler> layer = mBrowserManager->getLayerRenderHandler(i);
+        if (layer == nullptr || layer->getFrameCount() == 0)
+        {
+            continue;
+        }
 
-    //int width = bufferWidth;
-    //int height = bufferHeight;
-    int width = getWidth();
-    int height = getHeight();
+        const int index = LayerCompositor::kFirstBrowserLayer + i;
+        const juce::uint32 layerFrameCount = layer->getFrameCount();
+        float layerScale = 1.0f;
+        layer->readFrame([this, index, layerFrameCount, &layerScale](const uint32* pixels, int width, int height, float scale)
+        {
+            mCompositor.upload(index, pixels, width, height, layerFrameCount);
+            layerScale = scale;
+        });
 
-    char *pixelsPtr = (char*)mPixels;
+        const juce::Rectangle<int> bounds = mBrowserManager->getLayerBounds(i);
+        mCompositor.draw(index, getFrameBounds(index, layerScale, bounds.getPosition()), true);
+    }
 
-    for (int i = height - 1; i >= 0; i--)
+    // regions the page left for us, with the envelopes as fresh as the frame
+    mBrowserManager->getNativeWidgets(mWidgets);
+    if (!mWidgets.isEmpty())
     {
-        char* line = (char*)&pBufferPtr[i * width];
-        for (int j = 0; j < width; j++)
+        if (mWaveform != nullptr)
         {
-            // BGRA to RGBA !
-            *pixelsPtr++ = line[2];
-            *pixelsPtr++ = line[1];
-            *pixelsPtr++ = line[0];
-            *pixelsPtr++ = line[3];
+            mWaveform->update();
+        }
 
-            line += 4;
+        mWidgetRenderer.begin(getWidth(), getHeight());
+        for (const NativeWidget& widget : mWidgets)
+        {
+            mWidgetRenderer.draw(widget);
         }
+        mWidgetRenderer.end();
     }
 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glDisable(GL_DEPTH_TEST);
-    glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, mPixels);
-    glEnable(GL_DEPTH_TEST);
+    // pixels the page pushed from JS, uploaded from its own buffer
+    mCanvasTexture.draw(mBrowserManager->getSharedCanvas(), getWidth(), getHeight());
+
+    // popups go over everything
+    mRenderHandler->readPopup([this](const uint32* pixels, int width, int height, juce::uint32 popupFrame, juce::Rectangle<int> bounds)
+    {
+        mCompositor.upload(LayerCompositor::kPopupLayer, pixels, width, height, popupFrame);
+        mCompositor.draw(LayerCompositor::kPopupLayer, bounds.toFloat(), false);
+    });
+
+    double inputTime, paintTime;
+    if (mRenderHandler->takePresentedInput(frameCount, inputTime, paintTime))
+    {
+        mBrowserManager->addInputLatency(paintTime - inputTime, juce::Time::getMillisecondCounterHiRes() - inputTime);
+    }
+}
+
+void GLProcessorEditor::drawView()
+{
+    mCompositor.draw(LayerCompositor::kViewLayer, getFrameBounds(LayerCompositor::kViewLayer, mViewScale, juce::Point<int>()), false);
+}
+
+juce::Rectangle<float> GLProcessorEditor::getFrameBounds(int layer, float scale, juce::Point<int> topLeft) const
+{
+    // frames are painted at the render scale, they cover their page's size in view pixels
+    return juce::Rectangle<float>((float)topLeft.x, (float)topLeft.y,
+                                  (float)mCompositor.getFrameWidth(layer) / scale,
+                                  (float)mCompositor.getFrameHeight(layer) / scale);
+}
+
+void GLProcessorEditor::openGLContextClosing()
+{
+    mCompositor.release();
+    mCanvasTexture.release();
 }
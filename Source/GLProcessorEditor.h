@@ -1,9 +1,20 @@
 #pragma once
 
+#include <atomic>
+#include <future>
+#include "AnalysisWorkerPool.h"
 #include "BrowserManager.h"
+#include "CpuLoadMonitor.h"
+#include "InputQueue.h"
+#include "LayerCompositor.h"
+#include "NativeWidgets.h"
+#include "PluginSettings.h"
+#include "StartupTracer.h"
+#include "WaveformPyramid.h"
 #include "../JuceLibraryCode/JuceHeader.h"
 
 class BrowserManager;
+class GainPlugin;
 
 class GLProcessorEditor
     : public juce::AudioProcessorEditor
@@ -17,10 +28,16 @@ public:
     {
         kParamSliderHeight = 40,
         kParamLabelWidth = 80,
-        kParamSliderWidth = 300
+        kParamSliderWidth = 300,
+        kMetricsIntervalTicks = 10,
+        kLatencyBenchmarkSamples = 200,
+        kBinaryBenchmarkBytes = 16 * 1024 * 1024,
+        kRpcBenchmarkCalls = 20000,
+        kRenderScaleHoldMs = 1000,  // between two changes of the dynamic render scale
+        kRenderScaleIdleMs = 1000   // without paints before the full scale comes back
     };
 
-    GLProcessorEditor(juce::AudioProcessor& parent, BrowserManager* inBrowserManager);
+    GLProcessorEditor(GainPlugin& parent);
     virtual ~GLProcessorEditor();
 
 public:
@@ -32,6 +49,7 @@ public:
     virtual void mouseDown(const juce::MouseEvent& event) override;
     virtual void mouseDrag(const juce::MouseEvent& event) override;
     virtual void mouseUp(const juce::MouseEvent& event) override;
+    virtual void mouseExit(const juce::MouseEvent& event) override;
     virtual void mouseWheelMove(const juce::MouseEvent& event,
                                 const juce::MouseWheelDetails& wheel) override;
 
@@ -44,20 +62,29 @@ public:
     void sliderDragStarted(juce::Slider* slider) override;
     void sliderDragEnded(juce::Slider* slider) override;
 
+public:
+    // Shows url as a display-only browser over the view, at bounds in view pixels.
+    int addBrowserLayer(const juce::String& url, juce::Rectangle<int> bounds, int frameRate);
+
 private:
     void timerCallback() override;
+    void publishMetrics();
+    void startLatencyBenchmark(int numSamples);
+    void startBinaryBenchmark();
+    void updateRenderScale();
+    void setRenderScale(float scale);
     juce::AudioProcessorParameter* getParameterForSlider(juce::Slider* slider);
 
 private:
     void renderOpenGL() override;
+    void drawView();
+    juce::Rectangle<float> getFrameBounds(int layer, float scale, juce::Point<int> topLeft) const;
 
     void newOpenGLContextCreated() override
     {
     }
 
-    void openGLContextClosing() override
-    {
-    }
+    void openGLContextClosing() override;
 
 public:
     static const int                sWidth = 800;
@@ -71,9 +98,34 @@ private:
 
 private:
     BrowserManager*                 mBrowserManager;
+    InputQueue                      mInputQueue;
     CefRefPtr<RenderHandler>        mRenderHandler;
+    std::shared_future<bool>        mBrowserReady;
+    std::atomic<bool>               mBrowserShown;
+    bool                            mHasSnapshot;
+    double                          mOpenedAt;
+    juce::uint32                    mFrameCountAtOpen;
+    bool                            mSnapshotFrameShown;
+    bool                            mLiveFrameShown;
+    bool                            mFirstRenderTraced;
+    float                           mConfiguredRenderScale;     // 0 when dynamic
+    double                          mRenderScaleChangedAt;
+    WaveformPyramid*                mWaveform;
+    CpuLoadMonitor*                 mLoadMonitor;
+
+private:
+    juce::SharedResourcePointer<AnalysisWorkerPool> mAnalysisPool;
+    AnalysisWorkerPool::MetricsSnapshot mAnalysisMetrics;
+    AnalysisWorkerPool::Client      mAnalysisJobs;
+    int                             mTimerTicks;
+    bool                            mDrawsOverlays;
 
 private:
+    // GL thread only, released before the context goes
+    LayerCompositor                 mCompositor;
+    float                           mViewScale;
+    NativeWidgetRenderer            mWidgetRenderer;
+    juce::Array<NativeWidget>       mWidgets;
+    SharedCanvasTexture             mCanvasTexture;
     juce::OpenGLContext             mOpenGLContext;
-    uint32*                         mPixels;
 };
@@ -0,0 +1,38 @@
+#include "GainPlugin.h"
+#include "GLProcessorEditor.h"
+
+//==============================================================================
+void GainPlugin::addUiStateMethods()
+{
+    // the page keeps whatever it wants restored in a string, see ui.js
+    PluginState* state = &getState();
+    mBrowserManager->addRpcMethod ("getUiState", [state] (const juce::var&, juce::var& outResult)
+    {
+        const juce::MemoryBlock uiState = state->getUiState();
+        outResult = juce::String::fromUTF8 (static_cast<const char*> (uiState.getData()), static_cast<int> (uiState.getSize()));
+        return juce::Result::ok();
+    });
+
+    mBrowserManager->addRpcMethod ("setUiState", [state] (const juce::var& params, juce::var&)
+    {
+        if (! params.isString())
+            return juce::Result::fail ("setUiState takes a string");
+
+        const juce::String uiState = params.toString();
+        state->setUiState (uiState.toRawUTF8(), uiState.getNumBytesAsUTF8());
+        return juce::Result::ok();
+    });
+}
+
+//==============================================================================
+juce::AudioProcessorEditor* GainPlugin::createEditor()
+{
+    return new GLProcessorEditor (*this);
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new GainPlugin();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "BrowserManager.h"
+#include "GainProcessor.h"
+#include "StartupTracer.h"
+
+//==============================================================================
+/**
+    The plugin the host loads: the DSP core plus the CEF editor and the page's
+    access to the saved UI state.
+ */
+class GainPlugin :
+    public GainProcessor
+{
+public:
+
+    //==============================================================================
+    GainPlugin()
+    {
+        StartupTracer::addInstant ("PluginInstantiated");
+
+        mBrowserManager = new BrowserManager (this);
+        addUiStateMethods();
+    }
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock) override
+    {
+        GainProcessor::prepareToPlay (sampleRate, maximumExpectedSamplesPerBlock);
+        mBrowserManager->warmUp();
+    }
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override               { return true; }
+
+    //==============================================================================
+    BrowserManager* getBrowserManager()                 { return mBrowserManager; }
+
+private:
+    void addUiStateMethods();
+
+    //==============================================================================
+    // destroyed before GainProcessor's state, which its nativeRpc methods use
+    juce::ScopedPointer<BrowserManager> mBrowserManager;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainPlugin)
+};
@@ -24,98 +24,115 @@
   ==============================================================================
 */
 
-#include "include/cef_app.h"
-#include "GLProcessorEditor.h"
-#include "../JuceLibraryCode/JuceHeader.h"
+#include "GainProcessor.h"
+#include "RealtimeSafetyChecker.h"
 
 //==============================================================================
-/**
- */
-class GainProcessor :
-    public juce::AudioProcessor, public CefBrowserProcessHandler
+void GainProcessor::prepareToPlay (double sampleRate, int maximumExpectedSamplesPerBlock)
 {
-public:
-
-    //==============================================================================
-    GainProcessor()
-        : juce::AudioProcessor (BusesProperties().withInput("Input", juce::AudioChannelSet::stereo())
-                                           .withOutput ("Output", juce::AudioChannelSet::stereo()))
-        , mBrowserManager(this)
-    {
-        addParameter(freq = new juce::AudioParameterFloat ("freq", "Freq", 20.0f, 20000.0f, 20.f));
-        addParameter(gain = new juce::AudioParameterFloat("gain", "Gain", 0.0f, 1.0f, 0.5f));
-        addParameter(q = new juce::AudioParameterFloat("q", "Q", 1.0f, 10.0f, 1.f));
-    }
-
-    ~GainProcessor() {}
-
-    //==============================================================================
-    void prepareToPlay (double, int) override {}
-    void releaseResources() override {}
+    mWaveform.reset();
+    mLoadMonitor.prepare (sampleRate, maximumExpectedSamplesPerBlock);
+}
 
-    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) override
+void GainProcessor::releaseResources()
+{
+    // keep a trace of the session when it could not keep up
+    if (mLoadMonitor.getNumOverruns() > 0)
     {
-        buffer.applyGain (*gain);
+        const juce::File logFile = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                       .getChildFile ("CEFPlugIn")
+                                       .getChildFile ("load-" + juce::Time::getCurrentTime().formatted ("%Y%m%d-%H%M%S") + ".log");
+        logFile.getParentDirectory().createDirectory();
+        mLoadMonitor.exportLog (logFile);
     }
+}
 
-    //==============================================================================
-
-    juce::AudioProcessorEditor* createEditor() override { return new GLProcessorEditor(*this, &mBrowserManager); }
-    bool hasEditor() const override               { return true;   }
+void GainProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    const CpuLoadMonitor::ScopedBlockTimer blockTimer (mLoadMonitor, buffer.getNumSamples());
+    const RealtimeSafetyChecker::ScopedAudioThread audioThread;
 
-    //==============================================================================
-    const juce::String getName() const override         { return "CEF PlugIn"; }
-    bool acceptsMidi() const override                   { return false; }
-    bool producesMidi() const override                  { return false; }
-    double getTailLengthSeconds() const override        { return 0; }
+    buffer.applyGain (*gain);
+    mWaveform.pushBlock (buffer);
+}
 
-    //==============================================================================
-    int getNumPrograms() override                          { return 1; }
-    int getCurrentProgram() override                       { return 0; }
-    void setCurrentProgram (int) override                  {}
-    const juce::String getProgramName (int) override             { return juce::String(); }
-    void changeProgramName (int , const juce::String& ) override { }
+//==============================================================================
+void GainProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if (sizeInBytes <= 0 || mState.restore (data, static_cast<size_t> (sizeInBytes)))
+        return;
 
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override
-    {
-        juce::MemoryOutputStream (destData, true).writeFloat (*gain);
-    }
+    // sessions saved before PluginState hold the gain alone
+    if (sizeInBytes == sizeof (float))
+        *gain = juce::MemoryInputStream (data, static_cast<size_t> (sizeInBytes), false).readFloat();
+}
 
-    void setStateInformation (const void* data, int sizeInBytes) override
+//==============================================================================
+// Runs the processor through randomised block sizes and host automation and
+// fails on any allocation, deallocation or lock taken on the audio thread.
+// Fails outright in builds without CEFPLUGIN_RT_SAFETY_CHECKS, which could
+// not see any of them.
+class GainProcessorRealtimeSafetyTest : public juce::UnitTest
+{
+public:
+    GainProcessorRealtimeSafetyTest()
+        : juce::UnitTest ("GainProcessor real-time safety", "RealtimeSafety")
     {
-        gain->setValueNotifyingHost (juce::MemoryInputStream (data, static_cast<size_t> (sizeInBytes), false).readFloat());
     }
 
-    //==============================================================================
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override
+    void runTest() override
     {
-        const juce::AudioChannelSet& mainInLayout  = layouts.getChannelSet (true,  0);
-        const juce::AudioChannelSet& mainOutLayout = layouts.getChannelSet (false, 0);
-
-        return (mainInLayout == mainOutLayout && (! mainInLayout.isDisabled()));
+       #if ! CEFPLUGIN_RT_SAFETY_CHECKS
+        beginTest ("Checker compiled in");
+        expect (false, "built without CEFPLUGIN_RT_SAFETY_CHECKS, nothing on the audio thread is checked");
+       #else
+        beginTest ("Checker catches an allocation");
+        {
+            RealtimeSafetyChecker::clearViolations();
+            {
+                const RealtimeSafetyChecker::ScopedAudioThread audioThread;
+                int* volatile leak = new int (42);
+                delete leak;
+            }
+            expectEquals (RealtimeSafetyChecker::getNumViolations(), 2);
+        }
+
+        beginTest ("Randomised automation");
+        {
+            enum { kMaxBlockSize = 1024, kNumBlocks = 5000 };
+
+            juce::Random random (getRandom().nextInt64());
+            GainProcessor processor;
+            const juce::OwnedArray<juce::AudioProcessorParameter>& params = processor.getParameters();
+
+            processor.prepareToPlay (48000.0, kMaxBlockSize);
+            juce::AudioBuffer<float> storage (2, kMaxBlockSize);
+            juce::MidiBuffer midi;
+
+            RealtimeSafetyChecker::clearViolations();
+            for (int block = 0; block < kNumBlocks; ++block)
+            {
+                const int numSamples = 1 + random.nextInt (kMaxBlockSize);
+                juce::AudioBuffer<float> buffer (storage.getArrayOfWritePointers(), storage.getNumChannels(), numSamples);
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        buffer.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+                }
+
+                // hosts deliver automation on the audio thread right before processing
+                const RealtimeSafetyChecker::ScopedAudioThread audioThread;
+                if (random.nextInt (4) == 0)
+                    params[random.nextInt (params.size())]->setValue (random.nextFloat());
+
+                processor.processBlock (buffer, midi);
+            }
+            processor.releaseResources();
+
+            expectEquals (RealtimeSafetyChecker::getNumViolations(), 0, RealtimeSafetyChecker::describeViolations());
+        }
+       #endif
     }
-
-private:
-    //==============================================================================
-    juce::AudioParameterFloat* freq;
-    juce::AudioParameterFloat* gain;
-    juce::AudioParameterFloat* q;
-
-    enum { kVST2MaxChannels = 16 };
-
-    BrowserManager mBrowserManager;
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainProcessor)
-    
-private:
-    // Include the default reference counting implementation.
-    IMPLEMENT_REFCOUNTING(GainProcessor);
 };
 
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new GainProcessor();
-}
+static GainProcessorRealtimeSafetyTest gainProcessorRealtimeSafetyTest;
@@ -0,0 +1,308 @@
+#include "InputQueue.h"
+#include "PluginLog.h"
+
+InputQueue::InputQueue(BrowserManager& inBrowserManager)
+    : mBrowserManager(inBrowserManager)
+    , mMovePending(false)
+    , mWheelPending(false)
+    , mWheelX(0.0f)
+    , mWheelY(0.0f)
+    , mNumMoves(0)
+    , mNumMovesSent(0)
+    , mNumWheels(0)
+    , mNumWheelsSent(0)
+    , mBenchmarkSamples(0)
+    , mBenchmarkTicks(0)
+    , mBenchmarkStartedAt(0.0)
+{
+}
+
+InputQueue::~InputQueue()
+{
+    stopTimer();
+}
+
+// ----------------------------------------------------------------------------
+
+void InputQueue::mouseMove(const juce::MouseEvent& event)
+{
+    ++mNumMoves;
+    mPendingMove = toCefEvent(event);
+    mMovePending = true;
+    scheduleFlush();
+}
+
+void InputQueue::mouseButton(const juce::MouseEvent& event, bool mouseUp)
+{
+    // the button lands where the pointer was last seen
+    flush();
+
+    CefRefPtr<CefBrowser> browser = mBrowserManager.getBrowser();
+    if (browser == nullptr)
+    {
+        return;
+    }
+    // a click may change anything on the page
+    markDispatched(toCefEvent(event), true);
+    browser->GetHost()->SendMouseClickEvent(toCefEvent(event), getButton(event.mods), mouseUp, event.getNumberOfClicks());
+}
+
+void InputQueue::mouseExit(const juce::MouseEvent& event)
+{
+    flush();
+
+    CefRefPtr<CefBrowser> browser = mBrowserManager.getBrowser();
+    if (browser == nullptr)
+    {
+        return;
+    }
+    browser->GetHost()->SendMouseMoveEvent(toCefEvent(event), true);
+}
+
+void InputQueue::mouseWheel(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+    ++mNumWheels;
+    mWheelEvent = toCefEvent(event);
+    mWheelX += toWheelPixels(wheel.deltaX);
+    mWheelY += toWheelPixels(wheel.deltaY);
+    mWheelPending = true;
+    scheduleFlush();
+}
+
+void InputQueue::flush()
+{
+    CefRefPtr<CefBrowser> browser = mBrowserManager.getBrowser();
+    if (browser == nullptr)
+    {
+        mMovePending = false;
+        mWheelPending = false;
+        mWheelX = mWheelY = 0.0f;
+        return;
+    }
+
+    if (mMovePending)
+    {
+        mMovePending = false;
+        ++mNumMovesSent;
+        // a hover answers where the pointer is, a drag may move what it holds anywhere
+        const bool dragging = (mPendingMove.modifiers & (EVENTFLAG_LEFT_MOUSE_BUTTON | EVENTFLAG_MIDDLE_MOUSE_BUTTON | EVENTFLAG_RIGHT_MOUSE_BUTTON)) != 0;
+        markDispatched(mPendingMove, dragging);
+        browser->GetHost()->SendMouseMoveEvent(mPendingMove, false);
+    }
+
+    if (mWheelPending)
+    {
+        mWheelPending = false;
+
+        const int deltaX = takeWheelPixels(mWheelX);
+        const int deltaY = takeWheelPixels(mWheelY);
+        if (deltaX != 0 || deltaY != 0)
+        {
+            ++mNumWheelsSent;
+            markDispatched(mWheelEvent, true);
+            browser->GetHost()->SendMouseWheelEvent(mWheelEvent, deltaX, deltaY);
+        }
+    }
+}
+
+int InputQueue::takeWheelPixels(float& ioPending)
+{
+    const int pixels = (int)ioPending;
+    ioPending -= (float)pixels;
+    return pixels;
+}
+
+juce::var InputQueue::getMetrics() const
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("moves", mNumMoves);
+    metrics->setProperty("movesCollapsed", mNumMoves - mNumMovesSent);
+    metrics->setProperty("wheels", mNumWheels);
+    metrics->setProperty("wheelsCollapsed", mNumWheels - mNumWheelsSent);
+    return juce::var(metrics);
+}
+
+// ----------------------------------------------------------------------------
+
+void InputQueue::startLatencyBenchmark(juce::Rectangle<int> area, int numSamples, const juce::File& resultFile)
+{
+    if (isBenchmarkRunning() || numSamples <= 0 || area.isEmpty())
+    {
+        return;
+    }
+
+    mBenchmarkSamples = numSamples;
+    mBenchmarkTicks = 0;
+    mBenchmarkStartedAt = juce::Time::getMillisecondCounterHiRes();
+    mBenchmarkArea = area;
+    mBenchmarkFile = resultFile;
+
+    mBrowserManager.resetInputLatency();
+    setLatencyProbe(true);
+    startTimerHz(kDispatchRateHz);
+}
+
+// ----------------------------------------------------------------------------
+
+void InputQueue::timerCallback()
+{
+    if (isBenchmarkRunning())
+    {
+        benchmarkTick();
+    }
+
+    flush();
+
+    if (!isBenchmarkRunning())
+    {
+        stopTimer();
+    }
+}
+
+void InputQueue::markDispatched(const CefMouseEvent& event, bool anywhere)
+{
+    if (CefRefPtr<RenderHandler> renderHandler = mBrowserManager.getRenderHandler())
+    {
+        const juce::Rectangle<int> target = anywhere ? juce::Rectangle<int>()
+                                                     : juce::Rectangle<int>(event.x, event.y, 1, 1).expanded(RenderHandler::kInputTargetRadius);
+        renderHandler->markInput(juce::Time::getMillisecondCounterHiRes(), target);
+    }
+}
+
+void InputQueue::benchmarkTick()
+{
+    if (mBrowserManager.getNumInputLatencySamples() >= mBenchmarkSamples
+        || juce::Time::getMillisecondCounterHiRes() - mBenchmarkStartedAt > kBenchmarkTimeoutMs)
+    {
+        finishBenchmark();
+        return;
+    }
+
+    if (mBenchmarkTicks++ % kBenchmarkIntervalTicks != 0)
+    {
+        return;
+    }
+
+    // back and forth between two points, every move lands somewhere new
+    const bool left = (mBenchmarkTicks / kBenchmarkIntervalTicks) % 2 == 0;
+    mPendingMove = CefMouseEvent();
+    mPendingMove.x = mBenchmarkArea.getX() + mBenchmarkArea.getWidth() * (left ? 1 : 3) / 4;
+    mPendingMove.y = mBenchmarkArea.getCentreY();
+    mMovePending = true;
+}
+
+void InputQueue::finishBenchmark()
+{
+    setLatencyProbe(false);
+
+    const juce::int64 numSamples = mBrowserManager.getNumInputLatencySamples();
+    const double p50 = mBrowserManager.getInputLatencyPercentile(0.5);
+    const double p99 = mBrowserManager.getInputLatencyPercentile(0.99);
+    CEFPLUGIN_LOG_INFO("input", "latency benchmark samples=%d/%d p50=%.1fms p99=%.1fms",
+                       (int)numSamples, mBenchmarkSamples, p50, p99);
+
+    juce::DynamicObject* result = new juce::DynamicObject();
+    result->setProperty("requestedSamples", mBenchmarkSamples);
+    result->setProperty("complete", numSamples >= mBenchmarkSamples);
+    result->setProperty("latency", mBrowserManager.getInputLatencyMetrics());
+
+    mBenchmarkFile.getParentDirectory().createDirectory();
+    mBenchmarkFile.replaceWithText(juce::JSON::toString(juce::var(result)));
+    mBenchmarkSamples = 0;
+}
+
+void InputQueue::setLatencyProbe(bool enabled)
+{
+    if (CefRefPtr<CefBrowser> browser = mBrowserManager.getBrowser())
+    {
+        const juce::String script = juce::String("if (window.onPluginLatencyProbe) window.onPluginLatencyProbe(") + (enabled ? "true" : "false") + ");";
+        browser->GetMainFrame()->ExecuteJavaScript(script.toStdString(), "", 0);
+    }
+}
+
+void InputQueue::scheduleFlush()
+{
+    // restarting the timer on every event would hold the flush back while the mouse moves
+    if (!isTimerRunning())
+    {
+        startTimerHz(kDispatchRateHz);
+    }
+}
+
+CefMouseEvent InputQueue::toCefEvent(const juce::MouseEvent& event)
+{
+    CefMouseEvent cefEvent;
+    cefEvent.x = event.getPosition().getX();
+    cefEvent.y = event.getPosition().getY();
+
+    const juce::ModifierKeys& mods = event.mods;
+    cefEvent.modifiers = (mods.isShiftDown() ? EVENTFLAG_SHIFT_DOWN : 0)
+                       | (mods.isCtrlDown() ? EVENTFLAG_CONTROL_DOWN : 0)
+                       | (mods.isAltDown() ? EVENTFLAG_ALT_DOWN : 0)
+                       | (mods.isLeftButtonDown() ? EVENTFLAG_LEFT_MOUSE_BUTTON : 0)
+                       | (mods.isMiddleButtonDown() ? EVENTFLAG_MIDDLE_MOUSE_BUTTON : 0)
+                       | (mods.isRightButtonDown() ? EVENTFLAG_RIGHT_MOUSE_BUTTON : 0);
+    return cefEvent;
+}
+
+cef_mouse_button_type_t InputQueue::getButton(const juce::ModifierKeys& mods)
+{
+    // on mouseUp() the released button is still in the modifiers
+    if (mods.isLeftButtonDown())
+    {
+        return MBT_LEFT;
+    }
+    else if (mods.isMiddleButtonDown())
+    {
+        return MBT_MIDDLE;
+    }
+    else if (mods.isRightButtonDown())
+    {
+        return MBT_RIGHT;
+    }
+    return MBT_LEFT;
+}
+
+// ----------------------------------------------------------------------------
+
+// JUCE 5's Win32 peer turns WM_MOUSEWHEEL into amount = 0.5 * HIWORD(wParam) and
+// deltaY = amount / 256, see doMouseWheel() in juce_win32_Windowing.cpp, so a
+// notch of WHEEL_DELTA arrives as 0.5 * 120 / 256. CEF's Windows client passes
+// the raw 120 to SendMouseWheelEvent().
+class InputQueueWheelTest
+    : public juce::UnitTest
+{
+public:
+    InputQueueWheelTest()
+        : juce::UnitTest("InputQueue wheel deltas", "InputQueue")
+    {
+    }
+
+    void runTest() override
+    {
+        beginTest("One Windows notch");
+        {
+            float pending = InputQueue::toWheelPixels(0.5f * 120.0f / 256.0f);
+            expectEquals(InputQueue::takeWheelPixels(pending), 120);
+            expectEquals(pending, 0.0f);
+
+            pending = InputQueue::toWheelPixels(0.5f * -120.0f / 256.0f);
+            expectEquals(InputQueue::takeWheelPixels(pending), -120);
+        }
+
+        beginTest("Fractions carry over");
+        {
+            // half a pixel at a time, as smooth scrolling sends it
+            float pending = 0.0f;
+            int total = 0;
+            for (int i = 0; i < 240; ++i)
+            {
+                pending += InputQueue::toWheelPixels(0.5f * 0.5f / 256.0f);
+                total += InputQueue::takeWheelPixels(pending);
+            }
+            expectEquals(total, 120);
+        }
+    }
+};
+
+static InputQueueWheelTest inputQueueWheelTest;
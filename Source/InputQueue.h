@@ -0,0 +1,90 @@
+#pragma once
+
+#include "BrowserManager.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Mouse input of an editor on its way to the browser.
+
+    Moves and wheel deltas are coalesced and dispatched at most once per
+    frame, only the last position of a burst reaches Chromium. Buttons and
+    leaves go out immediately, after whatever is still pending, so their
+    order and position stay exact. Wheel deltas are accumulated as Chromium
+    pixels, fractions of a pixel carry over to the next frame.
+
+    Every dispatch is stamped on the RenderHandler for the input to photon
+    latency in BrowserManager. The latency benchmark sends synthetic moves
+    across the page and reports the percentiles of that latency.
+
+    Message thread only.
+*/
+class InputQueue
+    : private juce::Timer
+{
+public:
+    enum
+    {
+        kDispatchRateHz = 60,
+        kWheelPixelsPerUnit = 512,  // JUCE's Win32 peer reports WHEEL_DELTA units as 0.5 * units / 256
+        kBenchmarkIntervalTicks = 6,   // one input per 100 ms, answered before the next
+        kBenchmarkTimeoutMs = 60000
+    };
+
+    InputQueue(BrowserManager& inBrowserManager);
+    ~InputQueue();
+
+public:
+    void mouseMove(const juce::MouseEvent& event);
+    void mouseButton(const juce::MouseEvent& event, bool mouseUp);
+    void mouseExit(const juce::MouseEvent& event);
+    void mouseWheel(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel);
+
+    // Sends what is pending right away.
+    void flush();
+
+    juce::var getMetrics() const;
+
+    // A JUCE wheel delta in Chromium pixels, one Windows notch is 120 like
+    // in CEF's own Windows client. takeWheelPixels() returns the whole pixels
+    // pending and leaves the fraction for the next frame.
+    static float toWheelPixels(float delta)     { return delta * kWheelPixelsPerUnit; }
+    static int takeWheelPixels(float& ioPending);
+
+    // Moves between two points of the area until numSamples inputs are on
+    // screen, then logs the result and writes it to resultFile as JSON.
+    void startLatencyBenchmark(juce::Rectangle<int> area, int numSamples, const juce::File& resultFile);
+    bool isBenchmarkRunning() const     { return mBenchmarkSamples > 0; }
+
+private:
+    void timerCallback() override;
+    void scheduleFlush();
+    void markDispatched(const CefMouseEvent& event, bool anywhere);
+    void benchmarkTick();
+    void finishBenchmark();
+    void setLatencyProbe(bool enabled);
+    static CefMouseEvent toCefEvent(const juce::MouseEvent& event);
+    static cef_mouse_button_type_t getButton(const juce::ModifierKeys& mods);
+
+private:
+    BrowserManager&     mBrowserManager;
+
+    bool                mMovePending;
+    CefMouseEvent       mPendingMove;
+    bool                mWheelPending;
+    CefMouseEvent       mWheelEvent;
+    float               mWheelX;
+    float               mWheelY;
+
+    int                 mNumMoves;
+    int                 mNumMovesSent;
+    int                 mNumWheels;
+    int                 mNumWheelsSent;
+
+    int                 mBenchmarkSamples;      // 0 when not running
+    int                 mBenchmarkTicks;
+    double              mBenchmarkStartedAt;
+    juce::Rectangle<int> mBenchmarkArea;
+    juce::File          mBenchmarkFile;
+
+    JUCE_DECLARE_NON_COPYABLE(InputQueue)
+};
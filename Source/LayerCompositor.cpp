@@ -0,0 +1,131 @@
+#include "LayerCompositor.h"
+
+LayerCompositor::LayerCompositor()
+    : mViewWidth(1)
+    , mViewHeight(1)
+{
+}
+
+// ----------------------------------------------------------------------------
+
+void LayerCompositor::upload(int layer, const uint32* pixels, int width, int height, juce::uint32 frameNumber)
+{
+    while (mLayers.size() <= layer)
+    {
+        mLayers.add(new Layer());
+    }
+
+    Layer& target = *mLayers.getUnchecked(layer);
+    if ((target.hasFrame && target.frameNumber == frameNumber) || width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    // CEF paints BGRA, which is what loadARGB() uploads on little-endian machines
+    target.texture.loadARGB((const juce::PixelARGB*)pixels, width, height);
+    target.width = width;
+    target.height = height;
+    target.frameNumber = frameNumber;
+    target.hasFrame = true;
+}
+
+bool LayerCompositor::hasFrame(int layer) const
+{
+    const Layer* source = getLayer(layer);
+    return source != nullptr && source->hasFrame;
+}
+
+juce::uint32 LayerCompositor::getFrameNumber(int layer) const
+{
+    const Layer* source = getLayer(layer);
+    return source != nullptr ? source->frameNumber : 0;
+}
+
+int LayerCompositor::getFrameWidth(int layer) const
+{
+    const Layer* source = getLayer(layer);
+    return source != nullptr ? source->width : 0;
+}
+
+int LayerCompositor::getFrameHeight(int layer) const
+{
+    const Layer* source = getLayer(layer);
+    return source != nullptr ? source->height : 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void LayerCompositor::begin(int viewWidth, int viewHeight)
+{
+    mViewWidth = juce::jmax(1, viewWidth);
+    mViewHeight = juce::jmax(1, viewHeight);
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void LayerCompositor::draw(int layer, juce::Rectangle<float> bounds, bool blend)
+{
+    const Layer* source = getLayer(layer);
+    if (source == nullptr || !source->hasFrame || bounds.isEmpty())
+    {
+        return;
+    }
+
+    // view pixels, top down, to clip space
+    const float left = -1.0f + 2.0f * bounds.getX() / (float)mViewWidth;
+    const float right = -1.0f + 2.0f * bounds.getRight() / (float)mViewWidth;
+    const float top = 1.0f - 2.0f * bounds.getY() / (float)mViewHeight;
+    const float bottom = 1.0f - 2.0f * bounds.getBottom() / (float)mViewHeight;
+
+    // the texture may be padded to a power of two
+    const float u = (float)source->width / (float)source->texture.getWidth();
+    const float v = (float)source->height / (float)source->texture.getHeight();
+
+    glDisable(GL_DEPTH_TEST);
+    if (blend)
+    {
+        // CEF's pixels are premultiplied
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    else
+    {
+        glDisable(GL_BLEND);
+    }
+    glEnable(GL_TEXTURE_2D);
+    source->texture.bind();
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    // texture rows are top down like the page
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f);
+    glVertex2f(left, top);
+    glTexCoord2f(u, 0.0f);
+    glVertex2f(right, top);
+    glTexCoord2f(u, v);
+    glVertex2f(right, bottom);
+    glTexCoord2f(0.0f, v);
+    glVertex2f(left, bottom);
+    glEnd();
+
+    source->texture.unbind();
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void LayerCompositor::release()
+{
+    for (Layer* layer : mLayers)
+    {
+        layer->texture.release();
+        layer->hasFrame = false;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+LayerCompositor::Layer* LayerCompositor::getLayer(int layer) const
+{
+    return juce::isPositiveAndBelow(layer, mLayers.size()) ? mLayers.getUnchecked(layer) : nullptr;
+}
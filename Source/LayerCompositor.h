@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Composites browser frames as textured layers on the editor's GL context.
+
+    Each layer keeps its own texture and is only uploaded when its source
+    painted a new frame, so layers can update at independent rates. Frames
+    are CEF's premultiplied BGRA rows, top down, and are filtered to the
+    bounds they are drawn at, given in view pixels.
+
+    GL thread only, release() must be called before the context goes.
+*/
+class LayerCompositor
+{
+public:
+    enum
+    {
+        kViewLayer = 0,
+        kPopupLayer,
+        kFirstBrowserLayer
+    };
+
+    LayerCompositor();
+
+public:
+    // Uploads a frame unless the layer already holds frameNumber.
+    void upload(int layer, const uint32* pixels, int width, int height, juce::uint32 frameNumber);
+    bool hasFrame(int layer) const;
+    juce::uint32 getFrameNumber(int layer) const;
+
+    // Size of the layer's last frame, in its own pixels.
+    int getFrameWidth(int layer) const;
+    int getFrameHeight(int layer) const;
+
+    // Clears the viewport, which spans viewWidth x viewHeight view pixels.
+    void begin(int viewWidth, int viewHeight);
+    void draw(int layer, juce::Rectangle<float> bounds, bool blend);
+
+    // Forgets every texture, the next upload of each layer starts over.
+    void release();
+
+private:
+    struct Layer
+    {
+        juce::OpenGLTexture texture;
+        int                 width = 0;
+        int                 height = 0;
+        juce::uint32        frameNumber = 0;
+        bool                hasFrame = false;
+    };
+
+    Layer* getLayer(int layer) const;
+
+private:
+    juce::OwnedArray<Layer>     mLayers;
+    int                         mViewWidth;
+    int                         mViewHeight;
+
+    JUCE_DECLARE_NON_COPYABLE(LayerCompositor)
+};
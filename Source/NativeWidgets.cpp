@@ -0,0 +1,162 @@
+#include "NativeWidgets.h"
+
+namespace
+{
+    const juce::Colour sTrackColour(0xff3a3c42);
+    const juce::Colour sLevelColour(0xffe0a030);
+    const juce::Colour sPeakColour(0xffd0d0d0);
+
+    // dB range shown by a meter, and how fast its peak falls
+    const float sMeterFloorDb = -60.0f;
+    const float sPeakFallDbPerSecond = 20.0f;
+
+    float toMeterPosition(float gain)
+    {
+        const float db = juce::Decibels::gainToDecibels(gain, sMeterFloorDb);
+        return juce::jlimit(0.0f, 1.0f, 1.0f - db / sMeterFloorDb);
+    }
+}
+
+bool NativeWidget::parseKind(const juce::String& name, Kind& outKind)
+{
+    if (name == "meter")
+    {
+        outKind = kMeter;
+        return true;
+    }
+    if (name == "scope")
+    {
+        outKind = kScope;
+        return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+NativeWidgetRenderer::NativeWidgetRenderer(const WaveformPyramid* waveform)
+    : mWaveform(waveform)
+    , mLastDrawAt(0.0)
+    , mElapsedSeconds(0.0)
+{
+    mColumns.allocate(WaveformPyramid::kColumnsPerLevel, true);
+}
+
+void NativeWidgetRenderer::begin(int viewWidth, int viewHeight)
+{
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    mElapsedSeconds = mLastDrawAt > 0.0 ? juce::jmin(0.1, (now - mLastDrawAt) / 1000.0) : 0.0;
+    mLastDrawAt = now;
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0.0, juce::jmax(1, viewWidth), juce::jmax(1, viewHeight), 0.0, -1.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+}
+
+void NativeWidgetRenderer::draw(const NativeWidget& widget)
+{
+    if (mWaveform == nullptr || widget.bounds.isEmpty())
+    {
+        return;
+    }
+
+    switch (widget.kind)
+    {
+        case NativeWidget::kMeter:  drawMeter(widget); break;
+        case NativeWidget::kScope:  drawScope(widget); break;
+    }
+}
+
+void NativeWidgetRenderer::end()
+{
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+    glEnable(GL_DEPTH_TEST);
+}
+
+// ----------------------------------------------------------------------------
+
+void NativeWidgetRenderer::drawMeter(const NativeWidget& widget)
+{
+    const int numColumns = mWaveform->readLatest(kMeterLevel, mColumns, kMeterColumns);
+
+    float peak = 0.0f;
+    float sumSquares = 0.0f;
+    int numSamples = 0;
+    for (int i = 0; i < numColumns; ++i)
+    {
+        peak = juce::jmax(peak, std::abs(mColumns[i].min), std::abs(mColumns[i].max));
+        sumSquares += mColumns[i].sumSquares;
+        numSamples += mColumns[i].numSamples;
+    }
+    const float rms = numSamples > 0 ? std::sqrt(sumSquares / (float)numSamples) : 0.0f;
+
+    // the peak line holds and falls at a fixed rate
+    float& heldPeak = mMeterPeaks[widget.id];
+    const float fallen = heldPeak - (float)mElapsedSeconds * sPeakFallDbPerSecond / -sMeterFloorDb;
+    heldPeak = juce::jmax(toMeterPosition(peak), fallen);
+
+    const juce::Rectangle<float> area = widget.bounds.toFloat();
+    fillRect(area, sTrackColour);
+
+    // vertical meters fill upwards, horizontal ones to the right
+    if (area.getHeight() >= area.getWidth())
+    {
+        const float level = area.getHeight() * toMeterPosition(rms);
+        const float peakY = area.getBottom() - area.getHeight() * heldPeak;
+        fillRect(area.withTop(area.getBottom() - level), sLevelColour);
+        fillRect(juce::Rectangle<float>(area.getX(), juce::jmax(area.getY(), peakY - 1.0f), area.getWidth(), 2.0f), sPeakColour);
+    }
+    else
+    {
+        const float level = area.getWidth() * toMeterPosition(rms);
+        const float peakX = area.getX() + area.getWidth() * heldPeak;
+        fillRect(area.withWidth(level), sLevelColour);
+        fillRect(juce::Rectangle<float>(juce::jmin(area.getRight() - 2.0f, peakX - 1.0f), area.getY(), 2.0f, area.getHeight()), sPeakColour);
+    }
+}
+
+void NativeWidgetRenderer::drawScope(const NativeWidget& widget)
+{
+    const juce::Rectangle<float> area = widget.bounds.toFloat();
+    fillRect(area, sTrackColour);
+
+    // newest column at the right edge
+    const int numColumns = mWaveform->readLatest(kScopeLevel, mColumns, juce::jmin(widget.bounds.getWidth(), (int)WaveformPyramid::kColumnsPerLevel - 1));
+    const float left = area.getRight() - (float)numColumns;
+    const float centre = area.getCentreY();
+    const float halfHeight = area.getHeight() * 0.5f;
+
+    glColor4f(sLevelColour.getFloatRed(), sLevelColour.getFloatGreen(), sLevelColour.getFloatBlue(), 1.0f);
+    glBegin(GL_LINES);
+    for (int i = 0; i < numColumns; ++i)
+    {
+        const float x = left + (float)i + 0.5f;
+        const float top = centre - halfHeight * juce::jlimit(-1.0f, 1.0f, mColumns[i].max);
+        const float bottom = centre - halfHeight * juce::jlimit(-1.0f, 1.0f, mColumns[i].min);
+        glVertex2f(x, top);
+        glVertex2f(x, juce::jmax(bottom, top + 1.0f));
+    }
+    glEnd();
+}
+
+void NativeWidgetRenderer::fillRect(juce::Rectangle<float> area, juce::Colour colour)
+{
+    glColor4f(colour.getFloatRed(), colour.getFloatGreen(), colour.getFloatBlue(), 1.0f);
+    glBegin(GL_QUADS);
+    glVertex2f(area.getX(), area.getY());
+    glVertex2f(area.getRight(), area.getY());
+    glVertex2f(area.getRight(), area.getBottom());
+    glVertex2f(area.getX(), area.getBottom());
+    glEnd();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <map>
+#include "WaveformPyramid.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    A region of the page drawn natively instead of by Chromium.
+
+    The page declares its regions with window.setNativeWidgets() and keeps them
+    up to date on layout changes, see RendererApp. Bounds are in view pixels,
+    which are CSS pixels of the page at any render scale.
+*/
+struct NativeWidget
+{
+    enum Kind
+    {
+        kMeter = 0,
+        kScope
+    };
+
+    juce::String            id;
+    Kind                    kind;
+    juce::Rectangle<int>    bounds;
+
+    // "meter" or "scope", false for anything else.
+    static bool parseKind(const juce::String& name, Kind& outKind);
+};
+
+/**
+    Draws native widgets from the analysis data straight into the editor's GL
+    context, at the GL thread's frame rate and without Chromium repainting.
+
+    GL thread only.
+*/
+class NativeWidgetRenderer
+{
+public:
+    enum
+    {
+        kMeterLevel = 1,            // columns of 128 samples
+        kMeterColumns = 8,
+        kScopeLevel = 2             // one column of 512 samples per pixel
+    };
+
+    explicit NativeWidgetRenderer(const WaveformPyramid* waveform);
+
+public:
+    // Sets up view pixel coordinates, top down, for the following draw() calls.
+    void begin(int viewWidth, int viewHeight);
+    void draw(const NativeWidget& widget);
+    void end();
+
+private:
+    void drawMeter(const NativeWidget& widget);
+    void drawScope(const NativeWidget& widget);
+    static void fillRect(juce::Rectangle<float> area, juce::Colour colour);
+
+private:
+    const WaveformPyramid*                      mWaveform;
+    juce::HeapBlock<WaveformPyramid::Column>    mColumns;
+    double                                      mLastDrawAt;
+    double                                      mElapsedSeconds;
+    std::map<juce::String, float>               mMeterPeaks;
+
+    JUCE_DECLARE_NON_COPYABLE(NativeWidgetRenderer)
+};
@@ -0,0 +1,239 @@
+#include "PluginLog.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <unistd.h>
+#endif
+
+PluginLog::Ring PluginLog::sRings[PluginLog::kMaxThreads];
+std::atomic<juce::uint32> PluginLog::sNumDropped(0);
+
+namespace
+{
+    const char* getLevelName(PluginLog::Level level)
+    {
+        static const char* names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR" };
+        return names[juce::jlimit(0, 4, (int)level)];
+    }
+
+    int getProcessId()
+    {
+#if JUCE_WINDOWS
+        return (int)GetCurrentProcessId();
+#else
+        return (int)getpid();
+#endif
+    }
+}
+
+// A thread's claim on its ring, given back when the thread exits.
+class PluginLog::ThreadLease
+{
+public:
+    ThreadLease()
+        : mRing(nullptr)
+        , mClaimFailed(false)
+    {
+    }
+
+    ~ThreadLease()
+    {
+        if (mRing != nullptr)
+        {
+            mRing->state.store(kReleased, std::memory_order_release);
+        }
+    }
+
+    Ring* getRing()
+    {
+        if (mRing == nullptr && !mClaimFailed)
+        {
+            for (Ring& ring : sRings)
+            {
+                int expected = kFree;
+                if (ring.state.compare_exchange_strong(expected, kOwned, std::memory_order_acquire))
+                {
+                    ring.threadId = (juce::int64)(juce::pointer_sized_int)juce::Thread::getCurrentThreadId();
+                    mRing = &ring;
+                    break;
+                }
+            }
+            // not retried, the search would run on every record
+            mClaimFailed = mRing == nullptr;
+        }
+        return mRing;
+    }
+
+private:
+    Ring*   mRing;
+    bool    mClaimFailed;
+};
+
+// ----------------------------------------------------------------------------
+
+void PluginLog::write(Level level, const char* tag, const char* format, ...)
+{
+    Ring* ring = getThreadRing();
+    if (ring == nullptr)
+    {
+        sNumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const juce::uint32 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= (juce::uint32)kRingSize)
+    {
+        sNumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record& record = ring->records[head % kRingSize];
+    record.time = juce::Time::currentTimeMillis();
+    record.level = level;
+    record.tag = tag;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record.message, kMaxMessageLength, format, args);
+    va_end(args);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+juce::uint32 PluginLog::getNumDropped()
+{
+    return sNumDropped.load(std::memory_order_relaxed);
+}
+
+PluginLog::Ring* PluginLog::getThreadRing()
+{
+    static thread_local ThreadLease lease;
+    return lease.getRing();
+}
+
+// ----------------------------------------------------------------------------
+
+PluginLog::Writer::Writer()
+    : juce::Thread("Plugin log")
+    , mFile(juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("CEFPlugIn").getChildFile("CEFPlugIn.log"))
+    , mFileLock("CEFPlugIn-log")
+{
+    startThread(2);
+}
+
+PluginLog::Writer::~Writer()
+{
+    signalThreadShouldExit();
+    notify();
+    stopThread(2000);
+
+    // whatever was logged while shutting down
+    drain();
+}
+
+void PluginLog::Writer::run()
+{
+    while (!threadShouldExit())
+    {
+        drain();
+        wait(kDrainIntervalMs);
+    }
+}
+
+void PluginLog::Writer::drain()
+{
+    struct Entry
+    {
+        const Record*   record;
+        juce::int64     threadId;
+    };
+
+    struct Drained
+    {
+        Ring*           ring;
+        juce::uint32    head;
+        bool            wasReleased;
+    };
+
+    // each ring is in order, interleave them by time
+    juce::Array<Entry> entries;
+    juce::Array<Drained> drained;
+    for (Ring& ring : sRings)
+    {
+        // read before head, a released ring has its last records in by then
+        const int state = ring.state.load(std::memory_order_acquire);
+        if (state == kFree)
+        {
+            continue;
+        }
+
+        const juce::uint32 tail = ring.tail.load(std::memory_order_relaxed);
+        const juce::uint32 head = ring.head.load(std::memory_order_acquire);
+        for (juce::uint32 i = tail; i != head; ++i)
+        {
+            entries.add({ &ring.records[i % kRingSize], ring.threadId });
+        }
+        drained.add({ &ring, head, state == kReleased });
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.record->time < b.record->time; });
+
+    const juce::String pid(getProcessId());
+    juce::String text;
+    for (const Entry& entry : entries)
+    {
+        const Record& record = *entry.record;
+        text << juce::Time(record.time).formatted("%Y-%m-%d %H:%M:%S.") << juce::String(record.time % 1000).paddedLeft('0', 3)
+             << " " << pid
+             << " " << juce::String::toHexString(entry.threadId)
+             << " " << juce::String(getLevelName(record.level)).paddedRight(' ', 5)
+             << " [" << record.tag << "] " << juce::String::fromUTF8(record.message)
+             << juce::newLine;
+    }
+
+    // the records are formatted, the producers may reuse their slots and
+    // rings of exited threads go back to the free ones
+    for (const Drained& ring : drained)
+    {
+        ring.ring->tail.store(ring.head, std::memory_order_release);
+        if (ring.wasReleased)
+        {
+            ring.ring->state.store(kFree, std::memory_order_release);
+        }
+    }
+
+    if (text.isEmpty())
+    {
+        return;
+    }
+
+    const juce::InterProcessLock::ScopedLockType lock(mFileLock);
+    if (mFile.getSize() > kMaxFileSize)
+    {
+        rotate();
+    }
+
+    mFile.getParentDirectory().createDirectory();
+    juce::FileOutputStream stream(mFile);
+    if (stream.openedOk())
+    {
+        stream << text;
+    }
+}
+
+void PluginLog::Writer::rotate()
+{
+    // CEFPlugIn.log becomes CEFPlugIn.1.log, the oldest one is dropped
+    for (int i = kNumRotatedFiles; i > 0; --i)
+    {
+        const juce::File older = mFile.getSiblingFile(mFile.getFileNameWithoutExtension() + "." + juce::String(i) + mFile.getFileExtension());
+        const juce::File newer = i > 1 ? mFile.getSiblingFile(mFile.getFileNameWithoutExtension() + "." + juce::String(i - 1) + mFile.getFileExtension())
+                                       : mFile;
+        older.deleteFile();
+        newer.moveFileTo(older);
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// Statements below this level are compiled out, arguments included.
+#ifndef CEFPLUGIN_LOG_LEVEL
+ #if JUCE_DEBUG
+  #define CEFPLUGIN_LOG_LEVEL 1
+ #else
+  #define CEFPLUGIN_LOG_LEVEL 2
+ #endif
+#endif
+
+#define CEFPLUGIN_LOG(level, tag, ...) \
+    do { if ((int)(level) >= CEFPLUGIN_LOG_LEVEL) PluginLog::write((level), (tag), __VA_ARGS__); } while (false)
+
+#define CEFPLUGIN_LOG_TRACE(tag, ...)   CEFPLUGIN_LOG(PluginLog::kTrace, tag, __VA_ARGS__)
+#define CEFPLUGIN_LOG_DEBUG(tag, ...)   CEFPLUGIN_LOG(PluginLog::kDebug, tag, __VA_ARGS__)
+#define CEFPLUGIN_LOG_INFO(tag, ...)    CEFPLUGIN_LOG(PluginLog::kInfo, tag, __VA_ARGS__)
+#define CEFPLUGIN_LOG_WARNING(tag, ...) CEFPLUGIN_LOG(PluginLog::kWarning, tag, __VA_ARGS__)
+#define CEFPLUGIN_LOG_ERROR(tag, ...)   CEFPLUGIN_LOG(PluginLog::kError, tag, __VA_ARGS__)
+
+/**
+    Levelled log that can be written from any thread, CEF's UI and renderer
+    threads included, without locking or touching the file system.
+
+    Each thread formats its record into its own single-producer ring buffer,
+    a record that does not fit is counted and dropped. The rings are allocated
+    once, statically: a thread claims a free one the first time it logs, the
+    audio thread included, and hands it back when it exits. Records of a
+    thread that finds none free are dropped too.
+
+    A Writer drains every ring in the background to CEFPlugIn.log in the temp
+    folder, which is rotated once it grows past kMaxFileSize. Every plugin
+    instance holds one through a juce::SharedResourcePointer<PluginLog::Writer>,
+    so logs are written whether CEF runs or not. Instances in other hosts
+    append to the same file.
+
+    Use the CEFPLUGIN_LOG_* macros, tags and formats are printf-style literals.
+*/
+class PluginLog
+{
+public:
+    enum Level
+    {
+        kTrace = 0,
+        kDebug,
+        kInfo,
+        kWarning,
+        kError
+    };
+
+    enum
+    {
+        kRingSize = 256,
+        kMaxThreads = 32,
+        kMaxMessageLength = 200,
+        kMaxFileSize = 1 << 20,
+        kNumRotatedFiles = 3,
+        kDrainIntervalMs = 200
+    };
+
+    class Writer
+        : private juce::Thread
+    {
+    public:
+        Writer();
+        ~Writer();
+
+        juce::File getFile() const  { return mFile; }
+
+    private:
+        void run() override;
+        void drain();
+        void rotate();
+
+    private:
+        juce::File          mFile;
+        juce::InterProcessLock mFileLock;
+
+        JUCE_DECLARE_NON_COPYABLE(Writer)
+    };
+
+public:
+    static void write(Level level, const char* tag, const char* format, ...);
+
+    // Records lost to full rings since the process started.
+    static juce::uint32 getNumDropped();
+
+private:
+    struct Record
+    {
+        juce::int64     time;
+        Level           level;
+        const char*     tag;
+        char            message[kMaxMessageLength];
+    };
+
+    enum RingState
+    {
+        kFree = 0,
+        kOwned,
+        kReleased       // its thread exited, free once drained
+    };
+
+    struct Ring
+    {
+        Record                      records[kRingSize];
+        std::atomic<juce::uint32>   head;
+        std::atomic<juce::uint32>   tail;
+        std::atomic<int>            state;
+        juce::int64                 threadId;
+    };
+
+    class ThreadLease;
+
+    static Ring* getThreadRing();
+
+    static Ring                     sRings[kMaxThreads];
+    static std::atomic<juce::uint32> sNumDropped;
+};
@@ -0,0 +1,121 @@
+#include "PluginSettings.h"
+
+static juce::PropertiesFile::Options getSettingsOptions()
+{
+    juce::PropertiesFile::Options options;
+    options.applicationName = "CEFPlugIn";
+    options.filenameSuffix = ".settings";
+    options.folderName = "CEFPlugIn";
+    options.osxLibrarySubFolder = "Application Support";
+    options.storageFormat = juce::PropertiesFile::storeAsXML;
+    // several instances, possibly in several hosts, share the file
+    options.processLock = nullptr;
+    options.millisecondsBeforeSaving = 500;
+    return options;
+}
+
+PluginSettings::PluginSettings()
+    : mProperties(getSettingsOptions())
+{
+}
+
+// ----------------------------------------------------------------------------
+
+int PluginSettings::getWarmBrowserCount() const
+{
+    return juce::jlimit(0, 16, mProperties.getIntValue("warmBrowserCount", 1));
+}
+
+juce::int64 PluginSettings::getBrowserMemoryBudget() const
+{
+    return (juce::int64)mProperties.getIntValue("browserMemoryBudgetMB", 256) << 20;
+}
+
+int PluginSettings::getBrowserIdleTimeoutMs() const
+{
+    return 1000 * juce::jmax(0, mProperties.getIntValue("browserIdleTimeoutSeconds", 60));
+}
+
+bool PluginSettings::isMemoryCacheEnabled() const
+{
+    return mProperties.getBoolValue("browserMemoryCache", false);
+}
+
+juce::File PluginSettings::getCacheDirectory() const
+{
+    const juce::String path = mProperties.getValue("browserCachePath");
+    if (juce::File::isAbsolutePath(path))
+    {
+        return juce::File(path);
+    }
+    return mProperties.getFile().getSiblingFile("Cache");
+}
+
+bool PluginSettings::isBrowserHelperEnabled() const
+{
+    return mProperties.getBoolValue("browserHelper", true);
+}
+
+juce::File PluginSettings::getStartupTraceFile() const
+{
+    const juce::String path = mProperties.getValue("startupTraceFile");
+    return juce::File::isAbsolutePath(path) ? juce::File(path) : juce::File();
+}
+
+float PluginSettings::getRenderScale() const
+{
+    const float scale = (float)mProperties.getDoubleValue("renderScale", 1.0);
+    return scale <= 0.0f ? 0.0f : juce::jlimit(0.25f, 1.0f, scale);
+}
+
+int PluginSettings::getLatencyBenchmarkSamples() const
+{
+    return juce::jmax(0, mProperties.getIntValue("latencyBenchmarkSamples", 0));
+}
+
+// ----------------------------------------------------------------------------
+
+void PluginSettings::setWarmBrowserCount(int count)
+{
+    mProperties.setValue("warmBrowserCount", count);
+}
+
+void PluginSettings::setBrowserMemoryBudget(juce::int64 bytes)
+{
+    mProperties.setValue("browserMemoryBudgetMB", (int)(bytes >> 20));
+}
+
+void PluginSettings::setBrowserIdleTimeoutMs(int timeoutMs)
+{
+    mProperties.setValue("browserIdleTimeoutSeconds", timeoutMs / 1000);
+}
+
+void PluginSettings::setMemoryCacheEnabled(bool enabled)
+{
+    mProperties.setValue("browserMemoryCache", enabled);
+}
+
+void PluginSettings::setCacheDirectory(const juce::File& directory)
+{
+    mProperties.setValue("browserCachePath", directory.getFullPathName());
+}
+
+void PluginSettings::setBrowserHelperEnabled(bool enabled)
+{
+    mProperties.setValue("browserHelper", enabled);
+}
+
+void PluginSettings::setStartupTraceFile(const juce::File& file)
+{
+    mProperties.setValue("startupTraceFile", file.getFullPathName());
+}
+
+void PluginSettings::setRenderScale(float scale)
+{
+    mProperties.setValue("renderScale", scale);
+}
+
+void PluginSettings::setLatencyBenchmarkSamples(int numSamples)
+{
+    mProperties.setValue("latencyBenchmarkSamples", numSamples);
+}
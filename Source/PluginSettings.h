@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Machine-wide tuning knobs, read from CEFPlugIn.settings in the user's
+    application data folder and shared by every instance in the process through
+    a juce::SharedResourcePointer<PluginSettings>.
+
+    Missing keys fall back to the defaults below, the file is only written when
+    something calls one of the setters.
+*/
+class PluginSettings
+{
+public:
+    PluginSettings();
+
+public:
+    // Browser pool
+    int getWarmBrowserCount() const;
+    juce::int64 getBrowserMemoryBudget() const;
+    int getBrowserIdleTimeoutMs() const;
+
+    void setWarmBrowserCount(int count);
+    void setBrowserMemoryBudget(juce::int64 bytes);
+    void setBrowserIdleTimeoutMs(int timeoutMs);
+
+    // Browser storage, read once when CEF starts
+    bool isMemoryCacheEnabled() const;
+    juce::File getCacheDirectory() const;
+
+    void setMemoryCacheEnabled(bool enabled);
+    void setCacheDirectory(const juce::File& directory);
+
+    // Chromium's subprocesses run the browser helper when it is installed
+    bool isBrowserHelperEnabled() const;
+    void setBrowserHelperEnabled(bool enabled);
+
+    // Traces startup into this file when set, see StartupTracer
+    juce::File getStartupTraceFile() const;
+    void setStartupTraceFile(const juce::File& file);
+
+    // Chromium renders at this fraction of the editor's pixels, 0 adapts it
+    // to the frame time
+    float getRenderScale() const;
+    void setRenderScale(float scale);
+
+    // Runs the input latency benchmark when an editor opens, 0 when off
+    int getLatencyBenchmarkSamples() const;
+    void setLatencyBenchmarkSamples(int numSamples);
+
+private:
+    juce::PropertiesFile mProperties;
+
+    JUCE_DECLARE_NON_COPYABLE(PluginSettings)
+};
@@ -0,0 +1,161 @@
+#include "PluginState.h"
+#include <algorithm>
+
+namespace
+{
+    void writeUInt16(juce::uint8*& dest, juce::uint16 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        memcpy(dest, &value, sizeof(value));
+        dest += sizeof(value);
+    }
+
+    void writeUInt32(juce::uint8*& dest, juce::uint32 value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        memcpy(dest, &value, sizeof(value));
+        dest += sizeof(value);
+    }
+
+    void writeFloat(juce::uint8*& dest, float value)
+    {
+        juce::uint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        writeUInt32(dest, bits);
+    }
+
+    float readFloat(const juce::uint8* src)
+    {
+        const juce::uint32 bits = juce::ByteOrder::littleEndianInt(src);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+PluginState::PluginState()
+{
+}
+
+// ----------------------------------------------------------------------------
+
+void PluginState::bind(juce::AudioProcessor& processor)
+{
+    jassert(mEntries.isEmpty());
+    for (juce::AudioProcessorParameter* param : processor.getParameters())
+    {
+        // only parameters with an ID survive a change of their order
+        if (juce::AudioProcessorParameterWithID* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+        {
+            mEntries.add({ hashId(withId->paramID), param });
+        }
+    }
+    std::sort(mEntries.begin(), mEntries.end());
+
+    // two IDs with the same hash would restore into each other
+    for (int i = 1; i < mEntries.size(); ++i)
+    {
+        jassert(mEntries.getReference(i - 1).id != mEntries.getReference(i).id);
+    }
+}
+
+void PluginState::save(juce::MemoryBlock& destData) const
+{
+    const juce::ScopedLock sl(mUiLock);
+    destData.setSize(getSize());
+
+    juce::uint8* dest = static_cast<juce::uint8*>(destData.getData());
+    writeUInt32(dest, kMagic);
+    writeUInt16(dest, kVersion);
+    writeUInt16(dest, kEntrySize);
+    writeUInt32(dest, (juce::uint32)mEntries.size());
+    writeUInt32(dest, (juce::uint32)mUiState.getSize());
+
+    for (const Entry& entry : mEntries)
+    {
+        writeUInt32(dest, entry.id);
+        writeFloat(dest, entry.parameter->getValue());
+    }
+
+    if (mUiState.getSize() > 0)
+    {
+        memcpy(dest, mUiState.getData(), mUiState.getSize());
+    }
+}
+
+size_t PluginState::getSize() const
+{
+    const juce::ScopedLock sl(mUiLock);
+    return kHeaderSize + (size_t)mEntries.size() * kEntrySize + mUiState.getSize();
+}
+
+bool PluginState::restore(const void* data, size_t size)
+{
+    const juce::uint8* src = static_cast<const juce::uint8*>(data);
+    if (src == nullptr || size < kHeaderSize || juce::ByteOrder::littleEndianInt(src) != kMagic)
+    {
+        return false;
+    }
+
+    const juce::uint16 version = juce::ByteOrder::littleEndianShort(src + 4);
+    const size_t entrySize = juce::ByteOrder::littleEndianShort(src + 6);
+    const size_t numEntries = juce::ByteOrder::littleEndianInt(src + 8);
+    const size_t uiStateSize = juce::ByteOrder::littleEndianInt(src + 12);
+    if (version < 1 || entrySize < kEntrySize
+        || numEntries > (size - kHeaderSize) / entrySize
+        || uiStateSize > size - kHeaderSize - numEntries * entrySize)
+    {
+        return false;
+    }
+
+    src += kHeaderSize;
+    for (size_t i = 0; i < numEntries; ++i, src += entrySize)
+    {
+        if (juce::AudioProcessorParameter* param = find(juce::ByteOrder::littleEndianInt(src)))
+        {
+            param->setValueNotifyingHost(juce::jlimit(0.0f, 1.0f, readFloat(src + 4)));
+        }
+    }
+
+    setUiState(src, uiStateSize);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void PluginState::setUiState(const void* data, size_t size)
+{
+    const juce::ScopedLock sl(mUiLock);
+    if (size > 0)
+    {
+        mUiState.replaceWith(data, size);
+    }
+    else
+    {
+        mUiState.reset();
+    }
+}
+
+juce::MemoryBlock PluginState::getUiState() const
+{
+    const juce::ScopedLock sl(mUiLock);
+    return mUiState;
+}
+
+juce::uint32 PluginState::hashId(const juce::String& paramId)
+{
+    // FNV-1a of the UTF-8 ID, fixed forever once states are saved with it
+    juce::uint32 hash = 2166136261u;
+    for (const char* c = paramId.toRawUTF8(); *c != 0; ++c)
+    {
+        hash = (hash ^ (juce::uint8)*c) * 16777619u;
+    }
+    return hash;
+}
+
+juce::AudioProcessorParameter* PluginState::find(juce::uint32 id) const
+{
+    const Entry key = { id, nullptr };
+    const Entry* found = std::lower_bound(mEntries.begin(), mEntries.end(), key);
+    return found != mEntries.end() && found->id == id ? found->parameter : nullptr;
+}
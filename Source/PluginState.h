@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    The plugin's saved state: every parameter by stable ID and an opaque UI
+    state blob the page owns, e.g. its scroll position or localStorage.
+
+    Little-endian, version 1:
+        uint32  kMagic
+        uint16  version
+        uint16  bytes per parameter entry, 8 in version 1
+        uint32  number of parameter entries
+        uint32  UI state size
+        entries { uint32 hash of the paramID, float normalised value }
+        UI state bytes
+
+    Readers step over entries by their stated size and skip IDs they don't
+    know, so later versions may append fields. save() writes straight into the
+    host's block, which it resizes once, and restore() reads in place.
+*/
+class PluginState
+{
+public:
+    enum
+    {
+        kMagic = 0x53464543,    // "CEFS"
+        kVersion = 1,
+        kHeaderSize = 16,
+        kEntrySize = 8
+    };
+
+    PluginState();
+
+public:
+    // Once, after the processor added its parameters.
+    void bind(juce::AudioProcessor& processor);
+
+    void save(juce::MemoryBlock& destData) const;
+    size_t getSize() const;
+
+    // False if data is no state of this format, nothing is changed then.
+    bool restore(const void* data, size_t size);
+
+    // Any thread, the page reads and writes it through nativeRpc.
+    void setUiState(const void* data, size_t size);
+    juce::MemoryBlock getUiState() const;
+
+    static juce::uint32 hashId(const juce::String& paramId);
+
+private:
+    struct Entry
+    {
+        juce::uint32                    id;
+        juce::AudioProcessorParameter*  parameter;
+
+        bool operator<(const Entry& other) const    { return id < other.id; }
+    };
+
+    juce::AudioProcessorParameter* find(juce::uint32 id) const;
+
+private:
+    juce::Array<Entry>              mEntries;       // sorted by id
+    juce::MemoryBlock               mUiState;
+    mutable juce::CriticalSection   mUiLock;
+
+    JUCE_DECLARE_NON_COPYABLE(PluginState)
+};
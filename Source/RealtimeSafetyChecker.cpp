@@ -0,0 +1,274 @@
+#include "RealtimeSafetyChecker.h"
+
+#if CEFPLUGIN_RT_SAFETY_CHECKS
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <crtdbg.h>
+#else
+ #include <execinfo.h>
+#endif
+
+static thread_local int  tAudioThreadDepth = 0;
+static thread_local bool tInsideChecker = false;
+
+static RealtimeSafetyChecker::Violation sViolations[RealtimeSafetyChecker::kMaxViolations];
+static std::atomic<int> sNumViolations(0);
+
+// ----------------------------------------------------------------------------
+
+void RealtimeSafetyChecker::enterAudioThread()
+{
+    ++tAudioThreadDepth;
+}
+
+void RealtimeSafetyChecker::exitAudioThread()
+{
+    --tAudioThreadDepth;
+}
+
+bool RealtimeSafetyChecker::isAudioThread()
+{
+    return tAudioThreadDepth > 0 && !tInsideChecker;
+}
+
+void RealtimeSafetyChecker::reportViolation(ViolationType type, size_t size)
+{
+    tInsideChecker = true;
+
+    const int index = sNumViolations.fetch_add(1);
+    if (index < kMaxViolations)
+    {
+        Violation& violation = sViolations[index];
+        violation.type = type;
+        violation.size = size;
+#if JUCE_WINDOWS
+        violation.numFrames = CaptureStackBackTrace(1, kMaxStackFrames, violation.frames, nullptr);
+#else
+        violation.numFrames = backtrace(violation.frames, kMaxStackFrames);
+#endif
+    }
+
+    tInsideChecker = false;
+}
+
+int RealtimeSafetyChecker::getNumViolations()
+{
+    return sNumViolations.load();
+}
+
+const RealtimeSafetyChecker::Violation& RealtimeSafetyChecker::getViolation(int index)
+{
+    jassert(juce::isPositiveAndBelow(index, std::min(getNumViolations(), (int)kMaxViolations)));
+    return sViolations[index];
+}
+
+void RealtimeSafetyChecker::clearViolations()
+{
+    sNumViolations = 0;
+}
+
+juce::String RealtimeSafetyChecker::describeViolations()
+{
+    static const char* const typeNames[] = { "allocation", "deallocation", "lock" };
+
+    juce::String text;
+    const int numRecorded = std::min(getNumViolations(), (int)kMaxViolations);
+    for (int i = 0; i < numRecorded; ++i)
+    {
+        const Violation& violation = sViolations[i];
+        text << typeNames[violation.type];
+        if (violation.size > 0)
+        {
+            text << " (" << (juce::int64)violation.size << " bytes)";
+        }
+        text << " on the audio thread:\n";
+
+        for (int frame = 0; frame < violation.numFrames; ++frame)
+        {
+            text << "    0x" << juce::String::toHexString((juce::pointer_sized_int)violation.frames[frame]) << "\n";
+        }
+    }
+
+    if (getNumViolations() > numRecorded)
+    {
+        text << (getNumViolations() - numRecorded) << " more violations not recorded\n";
+    }
+    return text;
+}
+
+// ----------------------------------------------------------------------------
+// operator new/delete
+
+static void* checkedAllocate(size_t size)
+{
+    if (RealtimeSafetyChecker::isAudioThread())
+    {
+        RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::kAllocation, size);
+    }
+
+    // the CRT hook must not report this one a second time
+    const bool wasInside = tInsideChecker;
+    tInsideChecker = true;
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    tInsideChecker = wasInside;
+    return ptr;
+}
+
+static void checkedFree(void* ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+
+    if (RealtimeSafetyChecker::isAudioThread())
+    {
+        RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::kDeallocation, 0);
+    }
+
+    const bool wasInside = tInsideChecker;
+    tInsideChecker = true;
+    std::free(ptr);
+    tInsideChecker = wasInside;
+}
+
+void* operator new(size_t size)
+{
+    if (void* ptr = checkedAllocate(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return checkedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept                            { checkedFree(ptr); }
+void operator delete[](void* ptr) noexcept                          { checkedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept                    { checkedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept                  { checkedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept     { checkedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept   { checkedFree(ptr); }
+
+// ----------------------------------------------------------------------------
+// malloc/free and lock hooks
+
+#if JUCE_WINDOWS
+
+#if defined(_DEBUG)
+static int __cdecl crtAllocHook(int allocType, void*, size_t size, int blockType, long, const unsigned char*, int)
+{
+    if (blockType != _CRT_BLOCK && RealtimeSafetyChecker::isAudioThread())
+    {
+        RealtimeSafetyChecker::reportViolation(allocType == _HOOK_FREE ? RealtimeSafetyChecker::kDeallocation
+                                                                       : RealtimeSafetyChecker::kAllocation,
+                                               size);
+    }
+    return TRUE;
+}
+#endif
+
+typedef void (WINAPI* EnterCriticalSectionFunction)(LPCRITICAL_SECTION);
+static EnterCriticalSectionFunction sEnterCriticalSection = nullptr;
+
+static void WINAPI checkedEnterCriticalSection(LPCRITICAL_SECTION section)
+{
+    if (RealtimeSafetyChecker::isAudioThread())
+    {
+        RealtimeSafetyChecker::reportViolation(RealtimeSafetyChecker::kLock, 0);
+    }
+    sEnterCriticalSection(section);
+}
+
+// Redirects one entry of the module's import address table, which is what
+// every call made from JUCE code compiled into this module goes through.
+static void* patchImport(HMODULE module, const char* functionName, void* replacement)
+{
+    BYTE* base = (BYTE*)module;
+    const IMAGE_DOS_HEADER* dosHeader = (const IMAGE_DOS_HEADER*)base;
+    const IMAGE_NT_HEADERS* ntHeaders = (const IMAGE_NT_HEADERS*)(base + dosHeader->e_lfanew);
+    const IMAGE_DATA_DIRECTORY& imports = ntHeaders->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+    if (imports.VirtualAddress == 0)
+    {
+        return nullptr;
+    }
+
+    for (IMAGE_IMPORT_DESCRIPTOR* descriptor = (IMAGE_IMPORT_DESCRIPTOR*)(base + imports.VirtualAddress);
+         descriptor->Name != 0;
+         ++descriptor)
+    {
+        if (descriptor->OriginalFirstThunk == 0)
+        {
+            continue;
+        }
+
+        IMAGE_THUNK_DATA* names = (IMAGE_THUNK_DATA*)(base + descriptor->OriginalFirstThunk);
+        IMAGE_THUNK_DATA* thunks = (IMAGE_THUNK_DATA*)(base + descriptor->FirstThunk);
+        for (; names->u1.AddressOfData != 0; ++names, ++thunks)
+        {
+            if (IMAGE_SNAP_BY_ORDINAL(names->u1.Ordinal))
+            {
+                continue;
+            }
+
+            const IMAGE_IMPORT_BY_NAME* import = (const IMAGE_IMPORT_BY_NAME*)(base + names->u1.AddressOfData);
+            if (std::strcmp((const char*)import->Name, functionName) != 0)
+            {
+                continue;
+            }
+
+            DWORD oldProtection;
+            VirtualProtect(&thunks->u1.Function, sizeof(thunks->u1.Function), PAGE_READWRITE, &oldProtection);
+            void* original = (void*)thunks->u1.Function;
+            thunks->u1.Function = (ULONG_PTR)replacement;
+            VirtualProtect(&thunks->u1.Function, sizeof(thunks->u1.Function), oldProtection, &oldProtection);
+            return original;
+        }
+    }
+    return nullptr;
+}
+
+#endif
+
+static struct RealtimeSafetyHooks
+{
+    RealtimeSafetyHooks()
+    {
+#if JUCE_WINDOWS
+ #if defined(_DEBUG)
+        _CrtSetAllocHook(crtAllocHook);
+ #endif
+        // the plugin's DllMain has not run yet, so ask for the module holding this code
+        HMODULE module = nullptr;
+        GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (LPCWSTR)&patchImport, &module);
+        sEnterCriticalSection = (EnterCriticalSectionFunction)patchImport(module, "EnterCriticalSection",
+                                                                          (void*)checkedEnterCriticalSection);
+        jassert(sEnterCriticalSection != nullptr);
+#else
+        // the first backtrace() call loads the unwinder, which allocates
+        void* frames[1];
+        backtrace(frames, 1);
+#endif
+    }
+} sRealtimeSafetyHooks;
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+// Diagnostic mode, off by default: replaces the global operator new/delete of
+// the plugin module and hooks its lock acquisitions.
+#ifndef CEFPLUGIN_RT_SAFETY_CHECKS
+ #define CEFPLUGIN_RT_SAFETY_CHECKS 0
+#endif
+
+/**
+    Catches allocations, deallocations and lock acquisitions made from a thread
+    while it is marked as the audio thread.
+
+    processBlock() marks its thread with a ScopedAudioThread. When the checks
+    are compiled in, every violation is recorded with its call stack into a
+    preallocated buffer, which can be inspected once processing has stopped.
+    When they are not, the scope compiles to nothing.
+
+    - operator new/delete are replaced on every platform.
+    - malloc/free are seen through the debug CRT allocation hook (Windows
+      debug builds only).
+    - juce::CriticalSection (and any other Win32 critical section entered from
+      this module) is caught by patching the module's EnterCriticalSection
+      import (Windows only).
+*/
+class RealtimeSafetyChecker
+{
+public:
+    enum ViolationType
+    {
+        kAllocation,
+        kDeallocation,
+        kLock
+    };
+
+    enum
+    {
+        kMaxViolations = 64,
+        kMaxStackFrames = 32
+    };
+
+    struct Violation
+    {
+        ViolationType   type;
+        size_t          size;
+        int             numFrames;
+        void*           frames[kMaxStackFrames];
+    };
+
+    class ScopedAudioThread
+    {
+    public:
+        ScopedAudioThread()     { RealtimeSafetyChecker::enterAudioThread(); }
+        ~ScopedAudioThread()    { RealtimeSafetyChecker::exitAudioThread(); }
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+    };
+
+public:
+#if CEFPLUGIN_RT_SAFETY_CHECKS
+    static void enterAudioThread();
+    static void exitAudioThread();
+    static bool isAudioThread();
+    static void reportViolation(ViolationType type, size_t size);
+
+    // Total number of violations, may exceed kMaxViolations.
+    static int getNumViolations();
+    static const Violation& getViolation(int index);
+    static void clearViolations();
+    static juce::String describeViolations();
+#else
+    static void enterAudioThread()                      {}
+    static void exitAudioThread()                       {}
+    static bool isAudioThread()                         { return false; }
+    static void reportViolation(ViolationType, size_t)  {}
+
+    static int getNumViolations()                       { return 0; }
+    static void clearViolations()                       {}
+    static juce::String describeViolations()            { return juce::String(); }
+#endif
+};
@@ -0,0 +1,460 @@
+#include "RendererApp.h"
+
+const char* RendererApp::sParametersMessage = "parameters";
+const char* RendererApp::sSetParameterMessage = "setParameter";
+const char* RendererApp::sNativeWidgetsMessage = "nativeWidgets";
+const char* RendererApp::sRpcMessage = "rpc";
+const char* RendererApp::sRpcResultsMessage = "rpcResults";
+const char* RendererApp::sContextSetupMessage = "contextSetup";
+const char* RendererApp::sExtensionName = "v8/cefplugin";
+
+namespace
+{
+    // Registered once per renderer, V8 compiles it once and runs it for every
+    // new context ahead of OnContextCreated(). The natives are Execute().
+    //
+    // window.parameters is a plain object with one accessor per parameter,
+    // defined when the names become known, so its shape only changes then.
+    //
+    // binaryChannel.send() copies the page's bytes into renderer memory with
+    // one set(). nativeRpc batches the calls made in one tick from a
+    // microtask, past maxInFlight unanswered calls the rest wait here, so a
+    // flooding page slows itself down instead of the plugin.
+    const char* sExtensionScript =
+        "(function () {"
+        "    native function ContextSetUpStarted();"
+        "    native function GetParameter(index);"
+        "    native function SetParameter(index, value);"
+        "    native function GetParameterNames();"
+        "    native function SetNativeWidgets(widgets);"
+        "    native function AcquireBinary(size);"
+        "    native function CommitBinary(topic, size);"
+        "    native function DispatchRpc(batch);"
+        "    ContextSetUpStarted();"
+        ""
+        "    var parameters = {};"
+        "    function defineParameters() {"
+        "        GetParameterNames().forEach(function (name, index) {"
+        "            if (!Object.prototype.hasOwnProperty.call(parameters, name)) {"
+        "                Object.defineProperty(parameters, name, {"
+        "                    enumerable: true,"
+        "                    get: function () { return GetParameter(index); },"
+        "                    set: function (value) { SetParameter(index, value); }"
+        "                });"
+        "            }"
+        "        });"
+        "    }"
+        "    defineParameters();"
+        "    Object.defineProperty(window, 'parameters', { value: parameters, writable: true, enumerable: true });"
+        "    Object.defineProperty(window, 'setNativeWidgets', {"
+        "        value: function (widgets) { SetNativeWidgets(widgets); }, writable: true, enumerable: true"
+        "    });"
+        "    Object.defineProperty(window, 'cefPlugin', { value: { defineParameters: defineParameters } });"
+        "    if (window !== window.top) {"
+        "        return;"
+        "    }"
+        ""
+        "    var channel = { onmessage: null };"
+        "    channel.send = function (topic, data) {"
+        "        var bytes = ArrayBuffer.isView(data) ? new Uint8Array(data.buffer, data.byteOffset, data.byteLength) : new Uint8Array(data);"
+        "        new Uint8Array(AcquireBinary(bytes.byteLength)).set(bytes);"
+        "        CommitBinary(String(topic), bytes.byteLength);"
+        "    };"
+        "    Object.defineProperty(window, 'binaryChannel', { value: channel, enumerable: true });"
+        ""
+        "    var rpc = { maxInFlight: 256 };"
+        "    var nextId = 1, waiting = {}, queued = [], head = 0, inFlight = 0, scheduled = false;"
+        "    function flush() {"
+        "        scheduled = false;"
+        "        var batch = [];"
+        "        while (head < queued.length && inFlight < rpc.maxInFlight) {"
+        "            batch.push(queued[head++]);"
+        "            ++inFlight;"
+        "        }"
+        "        if (head === queued.length) {"
+        "            queued = [];"
+        "            head = 0;"
+        "        }"
+        "        if (batch.length > 0) {"
+        "            DispatchRpc(JSON.stringify(batch));"
+        "        }"
+        "    }"
+        "    function schedule() {"
+        "        if (!scheduled) {"
+        "            scheduled = true;"
+        "            Promise.resolve().then(flush);"
+        "        }"
+        "    }"
+        "    rpc.call = function (method, params) {"
+        "        return new Promise(function (resolve, reject) {"
+        "            var id = nextId++;"
+        "            waiting[id] = { resolve: resolve, reject: reject };"
+        "            queued.push({ id: id, method: String(method), params: params === undefined ? null : params });"
+        "            schedule();"
+        "        });"
+        "    };"
+        "    rpc.onresults = function (json) {"
+        "        JSON.parse(json).forEach(function (result) {"
+        "            var call = waiting[result.id];"
+        "            if (call) {"
+        "                delete waiting[result.id];"
+        "                --inFlight;"
+        "                if (result.error !== undefined) {"
+        "                    call.reject(new Error(result.error));"
+        "                } else {"
+        "                    call.resolve(result.result);"
+        "                }"
+        "            }"
+        "        });"
+        "        if (head < queued.length) {"
+        "            schedule();"
+        "        }"
+        "    };"
+        "    Object.defineProperty(rpc, 'pending', { get: function () { return queued.length - head + inFlight; } });"
+        "    Object.defineProperty(window, 'nativeRpc', { value: rpc, enumerable: true });"
+        "})();";
+}
+
+RendererApp::RendererApp()
+    : mSetUpStartedAt(0.0)
+{
+}
+
+// ----------------------------------------------------------------------------
+
+void RendererApp::OnWebKitInitialized()
+{
+    CefRegisterExtension(sExtensionName, sExtensionScript, this);
+}
+
+void RendererApp::OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefFrame> frame,
+                                   CefRefPtr<CefV8Context> context)
+{
+    if (frame->IsMain())
+    {
+        // transfers of the previous page are of no use to this one
+        mAssemblers.erase(browser->GetIdentifier());
+        mOutgoing.erase(browser->GetIdentifier());
+    }
+
+    // from the start of the extension to here, the bridge's cost per context
+    if (mSetUpStartedAt > 0.0)
+    {
+        CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(sContextSetupMessage);
+        message->GetArgumentList()->SetDouble(0, juce::Time::getMillisecondCounterHiRes() - mSetUpStartedAt);
+        browser->SendProcessMessage(PID_BROWSER, message);
+        mSetUpStartedAt = 0.0;
+    }
+}
+
+void RendererApp::OnBrowserDestroyed(CefRefPtr<CefBrowser> browser)
+{
+    mParameters.erase(browser->GetIdentifier());
+    mAssemblers.erase(browser->GetIdentifier());
+    mOutgoing.erase(browser->GetIdentifier());
+}
+
+bool RendererApp::OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                           CefProcessId source_process,
+                                           CefRefPtr<CefProcessMessage> message)
+{
+    if (message->GetName() == sRpcResultsMessage)
+    {
+        deliverRpcResults(browser, message->GetArgumentList()->GetString(0));
+        return true;
+    }
+    if (message->GetName() == BinaryChannel::sMessage)
+    {
+        juce::String topic;
+        juce::MemoryBlock data;
+        double ms;
+        if (mAssemblers[browser->GetIdentifier()].add(message->GetArgumentList(), topic, data, ms))
+        {
+            deliverBinary(browser, topic, data, ms);
+        }
+        return true;
+    }
+    if (message->GetName() != sParametersMessage)
+    {
+        return false;
+    }
+
+    juce::NamedValueSet& values = mParameters[browser->GetIdentifier()];
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    bool added = false;
+    for (size_t i = 0; i + 1 < args->GetSize(); i += 2)
+    {
+        const juce::Identifier name(juce::String(args->GetString(i).ToString()));
+        added = added || !values.contains(name);
+        values.set(name, args->GetDouble(i + 1));
+    }
+    if (added)
+    {
+        // the page may have been loaded before the browser was lent
+        defineParameters(browser);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool RendererApp::Execute(const CefString& name,
+                          CefRefPtr<CefV8Value> object,
+                          const CefV8ValueList& arguments,
+                          CefRefPtr<CefV8Value>& retval,
+                          CefString& exception)
+{
+    if (name == "ContextSetUpStarted")
+    {
+        mSetUpStartedAt = juce::Time::getMillisecondCounterHiRes();
+        return true;
+    }
+    if (name == "GetParameter")
+    {
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        double value;
+        if (context != nullptr && arguments.size() == 1 && arguments[0]->IsInt()
+            && getParameter(context->GetBrowser(), arguments[0]->GetIntValue(), value))
+        {
+            retval = CefV8Value::CreateDouble(value);
+        }
+        return true;
+    }
+    if (name == "SetParameter")
+    {
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (context != nullptr && arguments.size() == 2 && arguments[0]->IsInt()
+            && (arguments[1]->IsDouble() || arguments[1]->IsInt() || arguments[1]->IsUInt()))
+        {
+            setParameter(context->GetBrowser(), arguments[0]->GetIntValue(), arguments[1]->GetDoubleValue());
+        }
+        return true;
+    }
+    if (name == "GetParameterNames")
+    {
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        juce::StringArray names;
+        if (context != nullptr)
+        {
+            getParameterNames(context->GetBrowser(), names);
+        }
+
+        retval = CefV8Value::CreateArray(names.size());
+        for (int i = 0; i < names.size(); ++i)
+        {
+            retval->SetValue(i, CefV8Value::CreateString(names[i].toStdString()));
+        }
+        return true;
+    }
+    if (name == "DispatchRpc")
+    {
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (context != nullptr && arguments.size() == 1 && arguments[0]->IsString())
+        {
+            CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(sRpcMessage);
+            message->GetArgumentList()->SetString(0, arguments[0]->GetStringValue());
+            context->GetBrowser()->SendProcessMessage(PID_BROWSER, message);
+        }
+        return true;
+    }
+    if (name == "AcquireBinary")
+    {
+        // a fresh buffer each time, the page may still hold the previous one
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        const int size = arguments.size() == 1 && arguments[0]->IsInt() ? arguments[0]->GetIntValue() : -1;
+        if (context == nullptr || size < 0 || size > BinaryChannel::kMaxTransferSize)
+        {
+            exception = "binaryChannel.send() takes at most 256 MB";
+            return true;
+        }
+
+        BinaryChannel::Buffer::Ptr buffer = new BinaryChannel::Buffer();
+        buffer->data.setSize((size_t)size);
+        mOutgoing[context->GetBrowser()->GetIdentifier()] = buffer;
+        retval = buffer->createArrayBuffer();
+        return true;
+    }
+    if (name == "CommitBinary")
+    {
+        CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+        if (context == nullptr || arguments.size() != 2 || !arguments[0]->IsString() || !arguments[1]->IsInt())
+        {
+            return true;
+        }
+
+        auto outgoing = mOutgoing.find(context->GetBrowser()->GetIdentifier());
+        if (outgoing != mOutgoing.end())
+        {
+            const BinaryChannel::Buffer::Ptr buffer = outgoing->second;
+            mOutgoing.erase(outgoing);
+            const size_t size = juce::jmin(buffer->data.getSize(), (size_t)juce::jmax(0, arguments[1]->GetIntValue()));
+            BinaryChannel::send(context->GetBrowser(), PID_BROWSER, juce::String(arguments[0]->GetStringValue().ToString()), buffer->data.getData(), size);
+        }
+        return true;
+    }
+    if (name != "SetNativeWidgets")
+    {
+        return false;
+    }
+    if (arguments.size() != 1 || !arguments[0]->IsArray())
+    {
+        exception = "setNativeWidgets() takes an array of { id, kind, x, y, width, height }";
+        return true;
+    }
+
+    CefRefPtr<CefV8Context> context = CefV8Context::GetCurrentContext();
+    if (context == nullptr)
+    {
+        return true;
+    }
+
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(sNativeWidgetsMessage);
+    CefRefPtr<CefListValue> args = message->GetArgumentList();
+    CefRefPtr<CefV8Value> widgets = arguments[0];
+    size_t index = 0;
+    for (int i = 0; i < widgets->GetArrayLength(); ++i)
+    {
+        CefRefPtr<CefV8Value> widget = widgets->GetValue(i);
+        if (widget == nullptr || !widget->IsObject())
+        {
+            continue;
+        }
+
+        CefRefPtr<CefV8Value> id = widget->GetValue("id");
+        CefRefPtr<CefV8Value> kind = widget->GetValue("kind");
+        if (id == nullptr || !id->IsString() || kind == nullptr || !kind->IsString())
+        {
+            continue;
+        }
+
+        args->SetString(index++, id->GetStringValue());
+        args->SetString(index++, kind->GetStringValue());
+        const char* keys[] = { "x", "y", "width", "height" };
+        for (const char* key : keys)
+        {
+            // getBoundingClientRect() is fractional, the regions snap outwards
+            CefRefPtr<CefV8Value> value = widget->GetValue(key);
+            const double number = value != nullptr && (value->IsDouble() || value->IsInt()) ? value->GetDoubleValue() : 0.0;
+            args->SetInt(index++, (key == keys[0] || key == keys[1]) ? (int)std::floor(number) : (int)std::ceil(number));
+        }
+    }
+
+    context->GetBrowser()->SendProcessMessage(PID_BROWSER, message);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void RendererApp::defineParameters(CefRefPtr<CefBrowser> browser)
+{
+    CefRefPtr<CefV8Context> context = browser->GetMainFrame()->GetV8Context();
+    if (context == nullptr || !context->Enter())
+    {
+        return;
+    }
+
+    CefRefPtr<CefV8Value> plugin = context->GetGlobal()->GetValue("cefPlugin");
+    CefRefPtr<CefV8Value> define = plugin != nullptr && plugin->IsObject() ? plugin->GetValue("defineParameters") : nullptr;
+    if (define != nullptr && define->IsFunction())
+    {
+        define->ExecuteFunction(plugin, CefV8ValueList());
+    }
+    context->Exit();
+}
+
+void RendererApp::deliverRpcResults(CefRefPtr<CefBrowser> browser, const CefString& results)
+{
+    CefRefPtr<CefV8Context> context = browser->GetMainFrame()->GetV8Context();
+    if (context == nullptr || !context->Enter())
+    {
+        return;
+    }
+
+    CefRefPtr<CefV8Value> rpc = context->GetGlobal()->GetValue("nativeRpc");
+    CefRefPtr<CefV8Value> onResults = rpc != nullptr && rpc->IsObject() ? rpc->GetValue("onresults") : nullptr;
+    if (onResults != nullptr && onResults->IsFunction())
+    {
+        CefV8ValueList arguments;
+        arguments.push_back(CefV8Value::CreateString(results));
+        onResults->ExecuteFunction(rpc, arguments);
+    }
+    context->Exit();
+}
+
+void RendererApp::deliverBinary(CefRefPtr<CefBrowser> browser, const juce::String& topic, juce::MemoryBlock& data, double ms)
+{
+    CefRefPtr<CefV8Context> context = browser->GetMainFrame()->GetV8Context();
+    if (context == nullptr || !context->Enter())
+    {
+        return;
+    }
+
+    CefRefPtr<CefV8Value> channel = context->GetGlobal()->GetValue("binaryChannel");
+    CefRefPtr<CefV8Value> onMessage = channel != nullptr && channel->IsObject() ? channel->GetValue("onmessage") : nullptr;
+    if (onMessage != nullptr && onMessage->IsFunction())
+    {
+        // the page gets the reassembled bytes themselves
+        BinaryChannel::Buffer::Ptr buffer = new BinaryChannel::Buffer();
+        buffer->data.swapWith(data);
+
+        CefRefPtr<CefV8Value> info = CefV8Value::CreateObject(nullptr, nullptr);
+        info->SetValue("bytes", CefV8Value::CreateDouble((double)buffer->data.getSize()), V8_PROPERTY_ATTRIBUTE_NONE);
+        info->SetValue("ms", CefV8Value::CreateDouble(ms), V8_PROPERTY_ATTRIBUTE_NONE);
+
+        CefV8ValueList arguments;
+        arguments.push_back(CefV8Value::CreateString(topic.toStdString()));
+        arguments.push_back(buffer->createArrayBuffer());
+        arguments.push_back(info);
+        onMessage->ExecuteFunction(channel, arguments);
+    }
+    context->Exit();
+}
+
+// ----------------------------------------------------------------------------
+
+bool RendererApp::getParameter(CefRefPtr<CefBrowser> browser, int index, double& outValue)
+{
+    // the names were listed in the order they were first pushed
+    auto values = mParameters.find(browser->GetIdentifier());
+    if (values == mParameters.end() || !juce::isPositiveAndBelow(index, values->second.size()))
+    {
+        return false;
+    }
+
+    outValue = values->second.getValueAt(index);
+    return true;
+}
+
+void RendererApp::getParameterNames(CefRefPtr<CefBrowser> browser, juce::StringArray& outNames)
+{
+    auto values = mParameters.find(browser->GetIdentifier());
+    if (values != mParameters.end())
+    {
+        for (int i = 0; i < values->second.size(); ++i)
+        {
+            outNames.add(values->second.getName(i).toString());
+        }
+    }
+}
+
+bool RendererApp::setParameter(CefRefPtr<CefBrowser> browser, int index, double value)
+{
+    auto values = mParameters.find(browser->GetIdentifier());
+    if (values == mParameters.end() || !juce::isPositiveAndBelow(index, values->second.size()))
+    {
+        return false;
+    }
+
+    // answered locally right away, the browser process applies it
+    if (juce::var* current = values->second.getVarPointerAt(index))
+    {
+        *current = value;
+    }
+
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(sSetParameterMessage);
+    message->GetArgumentList()->SetInt(0, index);
+    message->GetArgumentList()->SetDouble(1, value);
+    browser->SendProcessMessage(PID_BROWSER, message);
+    return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <map>
+#include <include/cef_app.h>
+#include "BinaryChannel.h"
+#include "UiSchemeHandler.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Renderer side of the plugin, the whole CefApp of the browser helper
+    processes and the base of App in the plugin itself.
+
+    Every page gets window.parameters, one accessor per parameter name, each
+    bound to the parameter's index when it is defined so an access never
+    looks a name up. In a helper process the processors are out of reach, so
+    reads come from a per-browser copy the browser process pushes with
+    sParametersMessage, and writes are sent back as sSetParameterMessage. App
+    overrides both to reach the processors directly when everything runs in
+    one process.
+
+    window.setNativeWidgets([{ id, kind, x, y, width, height }, ...]) declares
+    the regions the editor draws natively, see NativeWidget. Every call
+    replaces the previous list and is sent on as sNativeWidgetsMessage.
+
+    The main frame also gets window.binaryChannel, see BinaryChannel, and
+    window.nativeRpc.call(method, params), which returns a Promise, see
+    RpcServer.
+
+    All of this is one V8 extension, registered once per renderer in
+    OnWebKitInitialized(), whose natives land in Execute(). A new context
+    runs glue V8 compiled once instead of objects built in OnContextCreated().
+*/
+class RendererApp
+    : public CefApp
+    , public CefRenderProcessHandler
+    , public CefV8Handler
+{
+public:
+    // browser -> renderer, arguments are name/value pairs in parameter order
+    static const char* sParametersMessage;
+    // renderer -> browser, arguments are parameter index and value
+    static const char* sSetParameterMessage;
+    // renderer -> browser, arguments are id, kind, x, y, width and height per widget
+    static const char* sNativeWidgetsMessage;
+    // renderer -> browser, a JSON batch of calls, and the results back
+    static const char* sRpcMessage;
+    static const char* sRpcResultsMessage;
+    // renderer -> browser, the ms a V8 context spent setting up the bridge
+    static const char* sContextSetupMessage;
+    static const char* sExtensionName;
+
+    RendererApp();
+
+public: // CefApp
+    virtual CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() override
+    {
+        return this;
+    }
+
+    virtual void OnRegisterCustomSchemes(CefRawPtr<CefSchemeRegistrar> registrar) override
+    {
+        UiSchemeHandlerFactory::registerScheme(registrar);
+    }
+
+public: // CefRenderProcessHandler
+    virtual void OnWebKitInitialized() override;
+
+    virtual void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefV8Context> context) override;
+
+    virtual void OnBrowserDestroyed(CefRefPtr<CefBrowser> browser) override;
+
+    virtual bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                          CefProcessId source_process,
+                                          CefRefPtr<CefProcessMessage> message) override;
+
+public: // CefV8Handler
+    virtual bool Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception) override;
+
+protected:
+    // Normalised values by index into the names, called on the renderer
+    // thread with a V8 context entered.
+    virtual bool getParameter(CefRefPtr<CefBrowser> browser, int index, double& outValue);
+    virtual bool setParameter(CefRefPtr<CefBrowser> browser, int index, double value);
+    virtual void getParameterNames(CefRefPtr<CefBrowser> browser, juce::StringArray& outNames);
+
+private:
+    void defineParameters(CefRefPtr<CefBrowser> browser);
+    void deliverRpcResults(CefRefPtr<CefBrowser> browser, const CefString& results);
+    void deliverBinary(CefRefPtr<CefBrowser> browser, const juce::String& topic, juce::MemoryBlock& data, double ms);
+
+private:
+    // renderer thread only
+    std::map<int, juce::NamedValueSet> mParameters;
+    std::map<int, BinaryChannel::Assembler> mAssemblers;
+    std::map<int, BinaryChannel::Buffer::Ptr> mOutgoing;     // acquired by the page, not committed yet
+    double mSetUpStartedAt;                                 // by the context being created
+
+public:
+    IMPLEMENT_REFCOUNTING(RendererApp);
+};
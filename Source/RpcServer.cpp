@@ -0,0 +1,156 @@
+#include "RpcServer.h"
+#include <include/cef_task.h>
+#include "CefUtils.h"
+#include "RendererApp.h"
+
+namespace
+{
+    juce::var makeResult(const juce::var& id, const juce::Identifier& key, const juce::var& value)
+    {
+        juce::DynamicObject* result = new juce::DynamicObject();
+        result->setProperty("id", id);
+        result->setProperty(key, value);
+        return juce::var(result);
+    }
+}
+
+RpcServer::RpcServer()
+    : mQueuedCalls(0)
+    , mNumCalls(0)
+    , mNumBatches(0)
+    , mNumRejected(0)
+{
+}
+
+// ----------------------------------------------------------------------------
+
+void RpcServer::addMethod(const juce::String& name, Method method)
+{
+    mMethods[name] = method;
+}
+
+void RpcServer::dispatch(CefRefPtr<CefBrowser> browser, const juce::String& batch)
+{
+    const juce::var calls = juce::JSON::parse(batch);
+    const juce::Array<juce::var>* array = calls.getArray();
+    if (array == nullptr || array->isEmpty())
+    {
+        return;
+    }
+
+    ++mNumBatches;
+    mNumCalls += array->size();
+    if (mQueuedCalls + array->size() > kMaxQueuedCalls)
+    {
+        mNumRejected += array->size();
+        rejectCalls(browser, calls, "busy");
+        return;
+    }
+
+    Batch* queued = new Batch { browser, calls };
+    {
+        const juce::ScopedLock sl(mQueueLock);
+        mQueued.add(queued);
+    }
+    mQueuedCalls += array->size();
+    mJobs.submit([this, queued]()
+    {
+        run(queued);
+    });
+}
+
+void RpcServer::reject(CefRefPtr<CefBrowser> browser, const juce::String& batch, const juce::String& error)
+{
+    rejectCalls(browser, juce::JSON::parse(batch), error);
+}
+
+void RpcServer::cancelAll()
+{
+    mJobs.cancelAll();
+
+    // the page would wait for these forever
+    juce::OwnedArray<Batch> cancelled;
+    {
+        const juce::ScopedLock sl(mQueueLock);
+        cancelled.swapWith(mQueued);
+    }
+    for (const Batch* batch : cancelled)
+    {
+        rejectCalls(batch->browser, batch->calls, "cancelled");
+    }
+    mQueuedCalls = 0;
+}
+
+juce::var RpcServer::getMetrics() const
+{
+    juce::DynamicObject* metrics = new juce::DynamicObject();
+    metrics->setProperty("calls", mNumCalls.load());
+    metrics->setProperty("batches", mNumBatches.load());
+    metrics->setProperty("callsPerBatch", mNumBatches > 0 ? (double)mNumCalls / (double)mNumBatches : 0.0);
+    metrics->setProperty("rejected", mNumRejected.load());
+    metrics->setProperty("queued", mQueuedCalls.load());
+    return juce::var(metrics);
+}
+
+// ----------------------------------------------------------------------------
+
+void RpcServer::run(Batch* queued)
+{
+    juce::ScopedPointer<Batch> batch;
+    {
+        const juce::ScopedLock sl(mQueueLock);
+        batch = mQueued.removeAndReturn(mQueued.indexOf(queued));
+    }
+    if (batch == nullptr)
+    {
+        return;
+    }
+
+    juce::Array<juce::var> results;
+    for (const juce::var& call : *batch->calls.getArray())
+    {
+        const juce::var id = call["id"];
+        auto method = mMethods.find(call["method"].toString());
+        if (method == mMethods.end())
+        {
+            results.add(makeResult(id, "error", "unknown method " + call["method"].toString()));
+            continue;
+        }
+
+        juce::var value;
+        const juce::Result result = method->second(call["params"], value);
+        results.add(result.wasOk() ? makeResult(id, "result", value) : makeResult(id, "error", result.getErrorMessage()));
+    }
+
+    mQueuedCalls -= results.size();
+    sendResults(batch->browser, results);
+}
+
+void RpcServer::rejectCalls(CefRefPtr<CefBrowser> browser, const juce::var& calls, const juce::String& error)
+{
+    if (const juce::Array<juce::var>* array = calls.getArray())
+    {
+        juce::Array<juce::var> results;
+        for (const juce::var& call : *array)
+        {
+            results.add(makeResult(call["id"], "error", error));
+        }
+        sendResults(browser, results);
+    }
+}
+
+void RpcServer::sendResults(CefRefPtr<CefBrowser> browser, const juce::Array<juce::var>& results)
+{
+    CefRefPtr<CefProcessMessage> message = CefProcessMessage::Create(RendererApp::sRpcResultsMessage);
+    message->GetArgumentList()->SetString(0, juce::JSON::toString(juce::var(results), true).toStdString());
+
+    // process messages leave from CEF's UI thread
+    if (CefCurrentlyOn(TID_UI))
+    {
+        browser->SendProcessMessage(PID_RENDERER, message);
+    }
+    else
+    {
+        CefPostTask(TID_UI, new FunctionTask([browser, message]() { browser->SendProcessMessage(PID_RENDERER, message); }));
+    }
+}
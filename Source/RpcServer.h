@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <include/cef_browser.h>
+#include "AnalysisWorkerPool.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Native side of window.nativeRpc, the page's Promise-based calls into the
+    plugin.
+
+    The page batches the calls it makes in one tick and sends each batch as a
+    single sRpcMessage of JSON [{ id, method, params }, ...], see RendererApp.
+    A batch runs as one job on the analysis worker pool, never on a CEF
+    thread, and its results go back as one sRpcResultsMessage of
+    [{ id, result } or { id, error }, ...].
+
+    Backpressure: the page keeps at most maxInFlight calls unanswered and
+    holds the rest, and batches that would take the native queue over
+    kMaxQueuedCalls are answered with a "busy" error right away.
+*/
+class RpcServer
+{
+public:
+    // Returns an error to reject the call's Promise with, or sets outResult.
+    typedef std::function<juce::Result(const juce::var& params, juce::var& outResult)> Method;
+
+    enum
+    {
+        kMaxQueuedCalls = 1024
+    };
+
+    RpcServer();
+
+public:
+    // Before the first dispatch().
+    void addMethod(const juce::String& name, Method method);
+
+    // CEF's UI thread: queues a batch, its results are sent to browser.
+    void dispatch(CefRefPtr<CefBrowser> browser, const juce::String& batch);
+
+    // Rejects every call of a batch, e.g. when no server is bound.
+    static void reject(CefRefPtr<CefBrowser> browser, const juce::String& batch, const juce::String& error);
+
+    // Rejects the queued batches and waits for the running ones, no handler
+    // is called anymore once this returns.
+    void cancelAll();
+
+    juce::var getMetrics() const;
+
+private:
+    struct Batch
+    {
+        CefRefPtr<CefBrowser>   browser;
+        juce::var               calls;
+    };
+
+    void run(Batch* batch);
+    static void rejectCalls(CefRefPtr<CefBrowser> browser, const juce::var& calls, const juce::String& error);
+    static void sendResults(CefRefPtr<CefBrowser> browser, const juce::Array<juce::var>& results);
+
+private:
+    std::map<juce::String, Method>  mMethods;
+    juce::OwnedArray<Batch>         mQueued;        // not picked up by a worker yet
+    juce::CriticalSection           mQueueLock;
+    std::atomic<int>                mQueuedCalls;
+    std::atomic<juce::int64>        mNumCalls;
+    std::atomic<juce::int64>        mNumBatches;
+    std::atomic<juce::int64>        mNumRejected;
+    AnalysisWorkerPool::Client      mJobs;          // last, waits for running jobs first
+
+    JUCE_DECLARE_NON_COPYABLE(RpcServer)
+};
@@ -0,0 +1,251 @@
+#include "SharedCanvas.h"
+
+namespace
+{
+    // Holds the canvas until V8 collects the buffer over its memory.
+    class BufferRelease
+        : public CefV8ArrayBufferReleaseCallback
+    {
+    public:
+        explicit BufferRelease(SharedCanvas* inCanvas)
+            : mCanvas(inCanvas)
+        {
+        }
+
+        void ReleaseBuffer(void* buffer) override
+        {
+            mCanvas = nullptr;
+        }
+
+    private:
+        SharedCanvas::Ptr mCanvas;
+
+        IMPLEMENT_REFCOUNTING(BufferRelease);
+    };
+
+    // present() and moveTo() of the page's object.
+    class CanvasBinding
+        : public CefV8Handler
+    {
+    public:
+        explicit CanvasBinding(SharedCanvas* inCanvas)
+            : mCanvas(inCanvas)
+        {
+        }
+
+        bool Execute(const CefString& name,
+                     CefRefPtr<CefV8Value> object,
+                     const CefV8ValueList& arguments,
+                     CefRefPtr<CefV8Value>& retval,
+                     CefString& exception) override
+        {
+            if (name == "present")
+            {
+                juce::Rectangle<int> area(mCanvas->getWidth(), mCanvas->getHeight());
+                if (arguments.size() > 0 && arguments[0]->IsObject())
+                {
+                    CefRefPtr<CefV8Value> rect = arguments[0];
+                    area = juce::Rectangle<int>(getInt(rect, "x"), getInt(rect, "y"), getInt(rect, "width"), getInt(rect, "height"));
+                }
+                mCanvas->present(area);
+                return true;
+            }
+            if (name == "moveTo")
+            {
+                if (arguments.size() != 2 || !isNumber(arguments[0]) || !isNumber(arguments[1]))
+                {
+                    exception = "moveTo() takes x and y in view pixels";
+                    return true;
+                }
+                mCanvas->moveTo(juce::Point<int>(juce::roundToInt(arguments[0]->GetDoubleValue()), juce::roundToInt(arguments[1]->GetDoubleValue())));
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        static bool isNumber(CefRefPtr<CefV8Value> value)
+        {
+            return value != nullptr && (value->IsInt() || value->IsUInt() || value->IsDouble());
+        }
+
+        static int getInt(CefRefPtr<CefV8Value> object, const char* key)
+        {
+            CefRefPtr<CefV8Value> value = object->GetValue(key);
+            return isNumber(value) ? juce::roundToInt(value->GetDoubleValue()) : 0;
+        }
+
+    private:
+        SharedCanvas::Ptr mCanvas;
+
+        IMPLEMENT_REFCOUNTING(CanvasBinding);
+    };
+}
+
+// ----------------------------------------------------------------------------
+
+SharedCanvas::SharedCanvas(int inWidth, int inHeight)
+    : mWidth(juce::jlimit(1, (int)kMaxSize, inWidth))
+    , mHeight(juce::jlimit(1, (int)kMaxSize, inHeight))
+    , mHasPresented(false)
+{
+    // transparent until the page presents something
+    mPixels.allocate((size_t)mWidth * (size_t)mHeight * 4, true);
+}
+
+CefRefPtr<CefV8Value> SharedCanvas::createV8Object()
+{
+    CefRefPtr<CanvasBinding> binding = new CanvasBinding(this);
+    CefRefPtr<CefV8Value> object = CefV8Value::CreateObject(nullptr, nullptr);
+    object->SetValue("buffer", CefV8Value::CreateArrayBuffer(mPixels, (size_t)mWidth * (size_t)mHeight * 4, new BufferRelease(this)), V8_PROPERTY_ATTRIBUTE_READONLY);
+    object->SetValue("width", CefV8Value::CreateInt(mWidth), V8_PROPERTY_ATTRIBUTE_READONLY);
+    object->SetValue("height", CefV8Value::CreateInt(mHeight), V8_PROPERTY_ATTRIBUTE_READONLY);
+    object->SetValue("present", CefV8Value::CreateFunction("present", binding), V8_PROPERTY_ATTRIBUTE_READONLY);
+    object->SetValue("moveTo", CefV8Value::CreateFunction("moveTo", binding), V8_PROPERTY_ATTRIBUTE_READONLY);
+    return object;
+}
+
+void SharedCanvas::present(juce::Rectangle<int> area)
+{
+    area = area.getIntersection(juce::Rectangle<int>(mWidth, mHeight));
+    if (area.isEmpty())
+    {
+        return;
+    }
+
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    mPresentedArea = mPresentedArea.isEmpty() ? area : mPresentedArea.getUnion(area);
+    mHasPresented = true;
+}
+
+void SharedCanvas::moveTo(juce::Point<int> position)
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    mPosition = position;
+}
+
+juce::Rectangle<int> SharedCanvas::takePresentedArea()
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    const juce::Rectangle<int> area = mPresentedArea;
+    mPresentedArea = juce::Rectangle<int>();
+    return area;
+}
+
+juce::Point<int> SharedCanvas::getPosition() const
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    return mPosition;
+}
+
+bool SharedCanvas::hasPresented() const
+{
+    const juce::SpinLock::ScopedLockType sl(mLock);
+    return mHasPresented;
+}
+
+// ----------------------------------------------------------------------------
+
+SharedCanvasTexture::SharedCanvasTexture()
+    : mTextureId(0)
+    , mTextureWidth(0)
+    , mTextureHeight(0)
+{
+}
+
+SharedCanvasTexture::~SharedCanvasTexture()
+{
+    // release() runs on the GL thread before the context goes
+    jassert(mTextureId == 0);
+}
+
+void SharedCanvasTexture::draw(SharedCanvas* canvas, int viewWidth, int viewHeight)
+{
+    if (canvas == nullptr)
+    {
+        mCanvas = nullptr;
+        return;
+    }
+    if (!canvas->hasPresented())
+    {
+        return;
+    }
+
+    juce::Rectangle<int> area = canvas->takePresentedArea();
+    if (canvas != mCanvas.get())
+    {
+        // a new canvas, or the texture went with the context
+        mCanvas = canvas;
+        area = juce::Rectangle<int>(canvas->getWidth(), canvas->getHeight());
+
+        if (mTextureId == 0 || canvas->getWidth() > mTextureWidth || canvas->getHeight() > mTextureHeight)
+        {
+            release();
+            mCanvas = canvas;
+            mTextureWidth = juce::nextPowerOfTwo(canvas->getWidth());
+            mTextureHeight = juce::nextPowerOfTwo(canvas->getHeight());
+
+            glGenTextures(1, &mTextureId);
+            glBindTexture(GL_TEXTURE_2D, mTextureId);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mTextureWidth, mTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, mTextureId);
+    if (!area.isEmpty())
+    {
+        // only the presented rect, read in place from the page's buffer
+        const juce::uint8* pixels = canvas->getPixels() + ((size_t)area.getY() * (size_t)canvas->getWidth() + (size_t)area.getX()) * 4;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, canvas->getWidth());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, area.getX(), area.getY(), area.getWidth(), area.getHeight(), GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    // view pixels, top down, to clip space
+    const juce::Rectangle<float> bounds(canvas->getPosition().toFloat(), canvas->getPosition().toFloat() + juce::Point<float>((float)canvas->getWidth(), (float)canvas->getHeight()));
+    const float left = -1.0f + 2.0f * bounds.getX() / (float)juce::jmax(1, viewWidth);
+    const float right = -1.0f + 2.0f * bounds.getRight() / (float)juce::jmax(1, viewWidth);
+    const float top = 1.0f - 2.0f * bounds.getY() / (float)juce::jmax(1, viewHeight);
+    const float bottom = 1.0f - 2.0f * bounds.getBottom() / (float)juce::jmax(1, viewHeight);
+    const float u = (float)canvas->getWidth() / (float)mTextureWidth;
+    const float v = (float)canvas->getHeight() / (float)mTextureHeight;
+
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_TEXTURE_2D);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f);
+    glVertex2f(left, top);
+    glTexCoord2f(u, 0.0f);
+    glVertex2f(right, top);
+    glTexCoord2f(u, v);
+    glVertex2f(right, bottom);
+    glTexCoord2f(0.0f, v);
+    glVertex2f(left, bottom);
+    glEnd();
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void SharedCanvasTexture::release()
+{
+    if (mTextureId != 0)
+    {
+        glDeleteTextures(1, &mTextureId);
+    }
+    mTextureId = 0;
+    mTextureWidth = 0;
+    mTextureHeight = 0;
+    mCanvas = nullptr;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <include/cef_v8.h>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    RGBA pixels a page writes from JS and the editor draws as an overlay,
+    without Chromium rasterising or painting them.
+
+    window.createSharedCanvas(width, height) returns
+    { buffer, width, height, present(rect), moveTo(x, y) }, where buffer is an
+    ArrayBuffer over this canvas' memory. The page writes non-premultiplied
+    RGBA rows into it, top down, and calls present() with the rect it changed
+    (the whole canvas without one). The GL thread uploads only what was
+    presented, straight from the same memory. Nothing is double-buffered, a
+    write racing an upload tears like a single-buffered canvas would.
+
+    Only where the page runs in the plugin process, see App.
+*/
+class SharedCanvas
+    : public juce::ReferenceCountedObject
+{
+public:
+    typedef juce::ReferenceCountedObjectPtr<SharedCanvas> Ptr;
+
+    enum
+    {
+        kMaxSize = 2048
+    };
+
+    SharedCanvas(int inWidth, int inHeight);
+
+public:
+    int getWidth() const        { return mWidth; }
+    int getHeight() const       { return mHeight; }
+    juce::uint8* getPixels()    { return mPixels; }
+
+    // Builds the page's object, which keeps the canvas alive for as long as
+    // V8 holds its buffer.
+    CefRefPtr<CefV8Value> createV8Object();
+
+    // Renderer thread.
+    void present(juce::Rectangle<int> area);
+    void moveTo(juce::Point<int> position);
+
+    // GL thread: the area presented since the last call, empty if none.
+    juce::Rectangle<int> takePresentedArea();
+    juce::Point<int> getPosition() const;
+    bool hasPresented() const;
+
+private:
+    juce::HeapBlock<juce::uint8>    mPixels;
+    const int                       mWidth;
+    const int                       mHeight;
+    juce::Rectangle<int>            mPresentedArea;
+    juce::Point<int>                mPosition;
+    bool                            mHasPresented;
+    juce::SpinLock                  mLock;
+
+    JUCE_DECLARE_NON_COPYABLE(SharedCanvas)
+};
+
+/**
+    The editor's texture of a SharedCanvas, drawn at the canvas' position in
+    view pixels.
+
+    GL thread only, release() must be called before the context goes.
+*/
+class SharedCanvasTexture
+{
+public:
+    SharedCanvasTexture();
+    ~SharedCanvasTexture();
+
+public:
+    void draw(SharedCanvas* canvas, int viewWidth, int viewHeight);
+    void release();
+
+private:
+    SharedCanvas::Ptr   mCanvas;
+    GLuint              mTextureId;
+    int                 mTextureWidth;
+    int                 mTextureHeight;
+
+    JUCE_DECLARE_NON_COPYABLE(SharedCanvasTexture)
+};
@@ -0,0 +1,277 @@
+#include "StartupTracer.h"
+#include <functional>
+#include <include/cef_task.h>
+#include <include/cef_trace.h>
+#include "CefUtils.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <unistd.h>
+#endif
+
+StartupTracer::Event StartupTracer::sEvents[StartupTracer::kMaxEvents];
+std::atomic<int> StartupTracer::sNumEvents(0);
+std::atomic<bool> StartupTracer::sChromiumTracing(false);
+std::atomic<bool> StartupTracer::sStartupExportPending(false);
+std::atomic<bool> StartupTracer::sStartupDone(false);
+juce::File StartupTracer::sStartupTraceFile;
+
+namespace
+{
+    // Chromium's tracing can only be driven from CEF's UI thread.
+    void runOnUiThread(std::function<void()> function)
+    {
+        if (CefCurrentlyOn(TID_UI))
+        {
+            function();
+        }
+        else
+        {
+            CefPostTask(TID_UI, new FunctionTask(function));
+        }
+    }
+
+    juce::int64 getCurrentThreadId()
+    {
+        return (juce::int64)(juce::pointer_sized_int)juce::Thread::getCurrentThreadId();
+    }
+
+    int getProcessId()
+    {
+#if JUCE_WINDOWS
+        return (int)GetCurrentProcessId();
+#else
+        return (int)getpid();
+#endif
+    }
+
+    double ticksToMicros(juce::int64 ticks)
+    {
+        return 1.0e6 * (double)ticks / (double)juce::Time::getHighResolutionTicksPerSecond();
+    }
+}
+
+class StartupTracer::TraceWriter
+    : public CefEndTracingCallback
+{
+public:
+    TraceWriter(const juce::File& inFile, bool inIsStartup)
+        : mFile(inFile)
+        , mIsStartup(inIsStartup)
+    {
+    }
+
+    void OnEndTracingComplete(const CefString& tracing_file) override
+    {
+        const juce::File chromiumTraceFile(juce::String(tracing_file.ToString()));
+        writeTrace(mFile, juce::JSON::parse(chromiumTraceFile));
+        chromiumTraceFile.deleteFile();
+
+        if (mIsStartup)
+        {
+            sStartupDone = true;
+        }
+    }
+
+private:
+    juce::File mFile;
+    bool mIsStartup;
+
+    IMPLEMENT_REFCOUNTING(TraceWriter);
+};
+
+// ----------------------------------------------------------------------------
+
+void StartupTracer::addInstant(const char* name, juce::int64 id)
+{
+    addEvent(name, 'i', juce::Time::getHighResolutionTicks(), 0, id);
+}
+
+void StartupTracer::addSpan(const char* name, juce::int64 startTicks, juce::int64 id)
+{
+    addEvent(name, 'X', startTicks, juce::Time::getHighResolutionTicks() - startTicks, id);
+}
+
+void StartupTracer::beginAsync(const char* name, juce::int64 id)
+{
+    addEvent(name, 'b', juce::Time::getHighResolutionTicks(), 0, id);
+}
+
+void StartupTracer::endAsync(const char* name, juce::int64 id)
+{
+    addEvent(name, 'e', juce::Time::getHighResolutionTicks(), 0, id);
+}
+
+void StartupTracer::addEvent(const char* name, char phase, juce::int64 ticks, juce::int64 durationTicks, juce::int64 id)
+{
+    const int index = sNumEvents.fetch_add(1, std::memory_order_relaxed);
+    if (index >= kMaxEvents)
+    {
+        // startup is long over by then
+        return;
+    }
+
+    Event& event = sEvents[index];
+    event.name = name;
+    event.phase = phase;
+    event.ticks = ticks;
+    event.durationTicks = durationTicks;
+    event.threadId = getCurrentThreadId();
+    event.id = id;
+    event.complete.store(true, std::memory_order_release);
+}
+
+void StartupTracer::editorOpened()
+{
+    if (sStartupDone.load(std::memory_order_acquire))
+    {
+        // an event another thread adds meanwhile may end up in either trace
+        const int numEvents = juce::jmin((int)sNumEvents.load(std::memory_order_relaxed), (int)kMaxEvents);
+        for (int i = 0; i < numEvents; ++i)
+        {
+            sEvents[i].complete.store(false, std::memory_order_relaxed);
+        }
+        sNumEvents.store(0, std::memory_order_release);
+    }
+    addInstant("EditorOpened");
+}
+
+// ----------------------------------------------------------------------------
+
+void StartupTracer::beginChromiumTracing(const juce::File& startupTraceFile)
+{
+    if (startupTraceFile == juce::File())
+    {
+        return;
+    }
+
+    sStartupTraceFile = startupTraceFile;
+    runOnUiThread([]()
+    {
+        // the default categories, enough to follow the browser and renderer startup
+        sChromiumTracing = CefBeginTracing("", nullptr);
+        sStartupExportPending.store(true, std::memory_order_release);
+    });
+}
+
+void StartupTracer::startupComplete()
+{
+    if (sStartupExportPending.exchange(false, std::memory_order_acquire))
+    {
+        exportTrace(sStartupTraceFile, true);
+    }
+    else if (sStartupTraceFile == juce::File())
+    {
+        // nothing to write, later opens may clear the buffer straight away
+        sStartupDone = true;
+    }
+}
+
+void StartupTracer::exportTrace(const juce::File& file)
+{
+    exportTrace(file, false);
+}
+
+void StartupTracer::exportTrace(const juce::File& file, bool isStartup)
+{
+    bool tracing = true;
+    if (sChromiumTracing.compare_exchange_strong(tracing, false))
+    {
+        // Chromium's tracing is not started again, later traces are native only
+        runOnUiThread([file, isStartup]() { CefEndTracing("", new TraceWriter(file, isStartup)); });
+        return;
+    }
+
+    writeTrace(file, juce::var());
+    if (isStartup)
+    {
+        sStartupDone = true;
+    }
+}
+
+juce::File StartupTracer::getDefaultTraceFile()
+{
+    return juce::File::getSpecialLocation(juce::File::tempDirectory)
+               .getChildFile("CEFPlugIn")
+               .getChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + ".json");
+}
+
+void StartupTracer::writeTrace(const juce::File& file, const juce::var& chromiumTrace)
+{
+    // Chromium stamps its events with the trace clock, the native events are
+    // moved onto it
+    const double offset = (double)CefNowFromSystemTraceTime() - ticksToMicros(juce::Time::getHighResolutionTicks());
+    const int pid = getProcessId();
+
+    juce::Array<juce::var> events;
+    const juce::var& chromiumEvents = chromiumTrace.isArray() ? chromiumTrace : chromiumTrace["traceEvents"];
+    if (const juce::Array<juce::var>* array = chromiumEvents.getArray())
+    {
+        events = *array;
+    }
+
+    const int numEvents = juce::jmin((int)sNumEvents.load(std::memory_order_relaxed), (int)kMaxEvents);
+    for (int i = 0; i < numEvents; ++i)
+    {
+        const Event& event = sEvents[i];
+        if (!event.complete.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        juce::DynamicObject* object = new juce::DynamicObject();
+        object->setProperty("name", event.name);
+        object->setProperty("cat", "CEFPlugIn");
+        object->setProperty("ph", juce::String::charToString(event.phase));
+        object->setProperty("ts", ticksToMicros(event.ticks) + offset);
+        object->setProperty("pid", pid);
+        object->setProperty("tid", event.threadId);
+
+        if (event.phase == 'X')
+        {
+            object->setProperty("dur", ticksToMicros(event.durationTicks));
+        }
+        else if (event.phase == 'i')
+        {
+            object->setProperty("s", "t");
+        }
+
+        if (event.phase == 'b' || event.phase == 'e')
+        {
+            object->setProperty("id", "0x" + juce::String::toHexString(event.id));
+        }
+        else if (event.id != 0)
+        {
+            juce::DynamicObject* args = new juce::DynamicObject();
+            args->setProperty("id", event.id);
+            object->setProperty("args", juce::var(args));
+        }
+        events.add(juce::var(object));
+    }
+
+    if (juce::MessageManager* messageManager = juce::MessageManager::getInstanceWithoutCreating())
+    {
+        juce::DynamicObject* args = new juce::DynamicObject();
+        args->setProperty("name", "JUCE message thread");
+
+        juce::DynamicObject* object = new juce::DynamicObject();
+        object->setProperty("name", "thread_name");
+        object->setProperty("ph", "M");
+        object->setProperty("pid", pid);
+        object->setProperty("tid", (juce::int64)(juce::pointer_sized_int)messageManager->getCurrentMessageThread());
+        object->setProperty("args", juce::var(args));
+        events.add(juce::var(object));
+    }
+
+    juce::DynamicObject* trace = new juce::DynamicObject();
+    trace->setProperty("traceEvents", events);
+    trace->setProperty("displayTimeUnit", "ms");
+    if (chromiumTrace.hasProperty("metadata"))
+    {
+        trace->setProperty("metadata", chromiumTrace["metadata"]);
+    }
+
+    file.getParentDirectory().createDirectory();
+    file.replaceWithText(juce::JSON::toString(juce::var(trace), true));
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Records where the time goes between plugin instantiation and the first
+    frame on screen, for startup and for every editor that opens.
+
+    Native spans and instants are added from any thread into a preallocated
+    buffer without locking. Once startup is over, every editor open starts the
+    buffer afresh. When enabled in PluginSettings, Chromium's own tracing runs
+    from CefInitialize() until the startup trace is written. exportTrace()
+    merges both into one Chrome trace JSON file that loads in chrome://tracing
+    or Perfetto.
+
+    Names must be string literals, only the pointer is stored.
+*/
+class StartupTracer
+{
+public:
+    enum
+    {
+        kMaxEvents = 1024
+    };
+
+    class ScopedSpan
+    {
+    public:
+        ScopedSpan(const char* inName, juce::int64 inId = 0)
+            : mName(inName)
+            , mId(inId)
+            , mStart(juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedSpan()
+        {
+            StartupTracer::addSpan(mName, mStart, mId);
+        }
+
+    private:
+        const char*     mName;
+        juce::int64     mId;
+        juce::int64     mStart;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedSpan)
+    };
+
+public:
+    static void addInstant(const char* name, juce::int64 id = 0);
+    static void addSpan(const char* name, juce::int64 startTicks, juce::int64 id = 0);
+
+    // For spans that end on another thread, matched by name and id.
+    static void beginAsync(const char* name, juce::int64 id);
+    static void endAsync(const char* name, juce::int64 id);
+
+    // Message thread, as an editor opens. Clears the buffer unless startup is
+    // still being traced, so a trace covers the latest open.
+    static void editorOpened();
+
+    // Called once CEF is initialised. Starts Chromium's tracing, the trace is
+    // written to startupTraceFile once the first editor shows a live frame
+    // and Chromium's tracing stops then.
+    static void beginChromiumTracing(const juce::File& startupTraceFile);
+    static void startupComplete();
+
+    // Any thread. Chromium's part arrives asynchronously, the file is written
+    // from CEF's UI thread then.
+    static void exportTrace(const juce::File& file);
+    static juce::File getDefaultTraceFile();
+
+private:
+    struct Event
+    {
+        const char*         name;
+        char                phase;
+        juce::int64         ticks;
+        juce::int64         durationTicks;
+        juce::int64         threadId;
+        juce::int64         id;
+        std::atomic<bool>   complete;
+    };
+
+    class TraceWriter;
+
+    static void addEvent(const char* name, char phase, juce::int64 ticks, juce::int64 durationTicks, juce::int64 id);
+    static void exportTrace(const juce::File& file, bool isStartup);
+    static void writeTrace(const juce::File& file, const juce::var& chromiumTrace);
+
+    static Event                sEvents[kMaxEvents];
+    static std::atomic<int>     sNumEvents;
+    static std::atomic<bool>    sChromiumTracing;
+    static std::atomic<bool>    sStartupExportPending;
+    static std::atomic<bool>    sStartupDone;       // its trace is written, the buffer may be cleared
+    static juce::File           sStartupTraceFile;
+};
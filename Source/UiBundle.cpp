@@ -0,0 +1,62 @@
+#include "UiBundle.h"
+
+UiBundle::UiBundle()
+{
+    juce::MemoryInputStream zipStream(BinaryData::ui_zip, (size_t)BinaryData::ui_zipSize, false);
+    juce::ZipFile zip(zipStream);
+
+    for (int i = 0; i < zip.getNumEntries(); ++i)
+    {
+        const juce::ZipFile::ZipEntry* entry = zip.getEntry(i);
+        if (entry->filename.endsWithChar('/'))
+        {
+            continue;
+        }
+
+        juce::ScopedPointer<juce::InputStream> stream(zip.createStreamForEntry(i));
+        if (stream == nullptr)
+        {
+            jassertfalse;
+            continue;
+        }
+
+        Resource* resource = new Resource();
+        resource->path = entry->filename.replaceCharacter('\\', '/');
+        resource->mimeType = getMimeType(resource->path);
+        stream->readIntoMemoryBlock(resource->data);
+        resource->etag = "\"" + juce::MD5(resource->data).toHexString() + "\"";
+
+        mResources.add(resource);
+        mIndex.set(resource->path, resource);
+    }
+}
+
+const UiBundle::Resource* UiBundle::find(const juce::String& path) const
+{
+    return mIndex[path];
+}
+
+const juce::String& UiBundle::getVersion()
+{
+    static const juce::String version = juce::MD5(BinaryData::ui_zip, (size_t)BinaryData::ui_zipSize).toHexString().substring(0, 12);
+    return version;
+}
+
+// ----------------------------------------------------------------------------
+
+juce::String UiBundle::getMimeType(const juce::String& path)
+{
+    const juce::String extension = path.fromLastOccurrenceOf(".", false, false).toLowerCase();
+
+    if (extension == "html" || extension == "htm")  return "text/html";
+    if (extension == "js")                          return "application/javascript";
+    if (extension == "css")                         return "text/css";
+    if (extension == "json")                        return "application/json";
+    if (extension == "svg")                         return "image/svg+xml";
+    if (extension == "png")                         return "image/png";
+    if (extension == "jpg" || extension == "jpeg")  return "image/jpeg";
+    if (extension == "woff")                        return "font/woff";
+    if (extension == "woff2")                       return "font/woff2";
+    if (extension == "wasm")                        return "application/wasm";
+    return "application/octet-stream";
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    The web UI, embedded as Resources/ui.zip and decompressed once into a
+    read-only in-memory index shared by the whole process through a
+    juce::SharedResourcePointer<UiBundle>.
+
+    Nothing is written after construction, so any thread can read it and
+    responses are served straight from the resources without copying them.
+*/
+class UiBundle
+{
+public:
+    struct Resource
+    {
+        juce::String        path;
+        juce::String        mimeType;
+        juce::String        etag;
+        juce::MemoryBlock   data;
+    };
+
+    UiBundle();
+
+public:
+    // nullptr if the bundle has no such file. Resources live as long as the bundle.
+    const Resource* find(const juce::String& path) const;
+    int getNumResources() const                     { return mResources.size(); }
+
+    // Changes with every change to the bundle, cheap to get without decompressing it.
+    static const juce::String& getVersion();
+
+private:
+    static juce::String getMimeType(const juce::String& path);
+
+private:
+    juce::OwnedArray<Resource>                      mResources;
+    juce::HashMap<juce::String, const Resource*>    mIndex;
+
+    JUCE_DECLARE_NON_COPYABLE(UiBundle)
+};
@@ -0,0 +1,211 @@
+#include "UiSchemeHandler.h"
+
+namespace
+{
+    // Parses "bytes=first-last", "bytes=first-" and "bytes=-suffix" into
+    // [outStart, outEnd). Several ranges are not supported.
+    bool parseRange(const juce::String& header, juce::int64 size, juce::int64& outStart, juce::int64& outEnd)
+    {
+        const juce::String spec = header.fromFirstOccurrenceOf("bytes=", false, true).trim();
+        if (spec.isEmpty() || !spec.containsChar('-') || spec.containsChar(','))
+        {
+            return false;
+        }
+
+        const juce::String first = spec.upToFirstOccurrenceOf("-", false, false).trim();
+        const juce::String last = spec.fromFirstOccurrenceOf("-", false, false).trim();
+        if (first.isEmpty())
+        {
+            const juce::int64 suffix = last.getLargeIntValue();
+            outStart = juce::jmax<juce::int64>(0, size - suffix);
+            outEnd = size;
+            return suffix > 0 && size > 0;
+        }
+
+        outStart = first.getLargeIntValue();
+        outEnd = last.isEmpty() ? size : juce::jmin(size, last.getLargeIntValue() + 1);
+        return outStart < outEnd;
+    }
+
+    class UiResourceHandler
+        : public CefResourceHandler
+    {
+    public:
+        UiResourceHandler(CefRefPtr<UiSchemeHandlerFactory> inFactory)
+            : mFactory(inFactory)
+            , mResource(nullptr)
+            , mImmutable(false)
+            , mStatus(404)
+            , mStart(0)
+            , mEnd(0)
+            , mOffset(0)
+        {
+        }
+
+    public: // CefResourceHandler
+        bool ProcessRequest(CefRefPtr<CefRequest> request, CefRefPtr<CefCallback> callback) override
+        {
+            const UiBundle& bundle = mFactory->getBundle();
+
+            juce::String path = juce::String(request->GetURL().ToString())
+                .fromFirstOccurrenceOf("://", false, false)
+                .fromFirstOccurrenceOf("/", false, false)
+                .upToFirstOccurrenceOf("?", false, false)
+                .upToFirstOccurrenceOf("#", false, false);
+            path = juce::URL::removeEscapeChars(path);
+
+            const juce::String versionPrefix = UiBundle::getVersion() + "/";
+            if (path.startsWith(versionPrefix))
+            {
+                path = path.substring(versionPrefix.length());
+                mImmutable = true;
+            }
+            else if (bundle.find(path) == nullptr && path.containsChar('/'))
+            {
+                // a page from an older build, its assets still resolve
+                path = path.fromFirstOccurrenceOf("/", false, false);
+            }
+            if (path.isEmpty() || path.endsWithChar('/'))
+            {
+                path += "index.html";
+            }
+
+            mResource = bundle.find(path);
+            if (mResource != nullptr)
+            {
+                const juce::int64 size = (juce::int64)mResource->data.getSize();
+                mStatus = 200;
+                mStart = 0;
+                mEnd = size;
+
+                CefRequest::HeaderMap headers;
+                request->GetHeaderMap(headers);
+                for (const auto& header : headers)
+                {
+                    const juce::String name(header.first.ToString());
+                    const juce::String value(header.second.ToString());
+
+                    if (name.equalsIgnoreCase("If-None-Match") && value == mResource->etag)
+                    {
+                        mStatus = 304;
+                        mStart = mEnd = 0;
+                        break;
+                    }
+                    if (name.equalsIgnoreCase("Range"))
+                    {
+                        juce::int64 start, end;
+                        if (parseRange(value, size, start, end))
+                        {
+                            mStatus = 206;
+                            mStart = start;
+                            mEnd = end;
+                        }
+                        else if (value.containsChar(','))
+                        {
+                            // several ranges, the whole resource is a valid answer
+                        }
+                        else
+                        {
+                            mStatus = 416;
+                            mStart = mEnd = 0;
+                        }
+                    }
+                }
+            }
+            mOffset = mStart;
+
+            callback->Continue();
+            return true;
+        }
+
+        void GetResponseHeaders(CefRefPtr<CefResponse> response, int64& response_length, CefString& redirectUrl) override
+        {
+            response->SetStatus(mStatus);
+            response_length = mEnd - mStart;
+
+            if (mResource == nullptr)
+            {
+                response->SetStatusText("Not Found");
+                return;
+            }
+
+            const juce::int64 size = (juce::int64)mResource->data.getSize();
+
+            CefResponse::HeaderMap headers;
+            headers.insert(std::make_pair("Cache-Control", mImmutable ? "public, max-age=31536000, immutable" : "no-cache"));
+            headers.insert(std::make_pair("ETag", mResource->etag.toStdString()));
+            headers.insert(std::make_pair("Accept-Ranges", "bytes"));
+
+            switch (mStatus)
+            {
+                case 206:
+                    response->SetStatusText("Partial Content");
+                    headers.insert(std::make_pair("Content-Range", ("bytes " + juce::String(mStart) + "-" + juce::String(mEnd - 1) + "/" + juce::String(size)).toStdString()));
+                    break;
+                case 304:
+                    response->SetStatusText("Not Modified");
+                    break;
+                case 416:
+                    response->SetStatusText("Range Not Satisfiable");
+                    headers.insert(std::make_pair("Content-Range", ("bytes */" + juce::String(size)).toStdString()));
+                    break;
+                default:
+                    response->SetStatusText("OK");
+                    break;
+            }
+
+            response->SetMimeType(mResource->mimeType.toStdString());
+            response->SetHeaderMap(headers);
+        }
+
+        bool ReadResponse(void* data_out, int bytes_to_read, int& bytes_read, CefRefPtr<CefCallback> callback) override
+        {
+            bytes_read = (int)juce::jmin<juce::int64>(bytes_to_read, mEnd - mOffset);
+            if (bytes_read <= 0)
+            {
+                bytes_read = 0;
+                return false;
+            }
+
+            // straight from the shared index, nothing is buffered per request
+            memcpy(data_out, static_cast<const char*>(mResource->data.getData()) + mOffset, (size_t)bytes_read);
+            mOffset += bytes_read;
+            return true;
+        }
+
+        void Cancel() override
+        {
+        }
+
+    private:
+        CefRefPtr<UiSchemeHandlerFactory>   mFactory;   // keeps the bundle alive
+        const UiBundle::Resource*           mResource;
+        bool                                mImmutable;
+        int                                 mStatus;
+        juce::int64                         mStart;
+        juce::int64                         mEnd;
+        juce::int64                         mOffset;
+
+        IMPLEMENT_REFCOUNTING(UiResourceHandler);
+    };
+}
+
+// ----------------------------------------------------------------------------
+
+bool UiSchemeHandlerFactory::registerFactory(CefRefPtr<CefRequestContext> context)
+{
+    return context->RegisterSchemeHandlerFactory(getScheme(), getHost(), new UiSchemeHandlerFactory());
+}
+
+juce::String UiSchemeHandlerFactory::getEntryUrl()
+{
+    return juce::String(getScheme()) + "://" + getHost() + "/" + UiBundle::getVersion() + "/index.html";
+}
+
+CefRefPtr<CefResourceHandler> UiSchemeHandlerFactory::Create(CefRefPtr<CefBrowser> browser,
+                                                             CefRefPtr<CefFrame> frame,
+                                                             const CefString& scheme_name,
+                                                             CefRefPtr<CefRequest> request)
+{
+    return new UiResourceHandler(this);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <include/cef_request_context.h>
+#include <include/cef_resource_handler.h>
+#include <include/cef_scheme.h>
+#include "UiBundle.h"
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Serves the bundled UI at plugin://ui/, page loads never touch the disk.
+
+    Pages are addressed as plugin://ui/<bundle version>/<path>, so everything
+    under a version can be cached for good; unversioned requests revalidate
+    through the ETag. Single byte ranges are honoured.
+*/
+class UiSchemeHandlerFactory
+    : public CefSchemeHandlerFactory
+{
+public:
+    static const char* getScheme()      { return "plugin"; }
+    static const char* getHost()        { return "ui"; }
+
+    // Has to be called from CefApp::OnRegisterCustomSchemes() in every process,
+    // inline so the browser helper does not need the bundle.
+    static void registerScheme(CefRawPtr<CefSchemeRegistrar> registrar)
+    {
+        // standard so relative URLs resolve, secure so the page gets secure-context APIs
+        registrar->AddCustomScheme(getScheme(), true, false, false, true, true, false);
+    }
+
+    // Registers a factory on the request context the browsers use, once CEF
+    // is initialised. A context of its own does not see the global factories.
+    static bool registerFactory(CefRefPtr<CefRequestContext> context);
+
+    // URL of the UI's entry page.
+    static juce::String getEntryUrl();
+
+public:
+    const UiBundle& getBundle() const   { return *mBundle; }
+
+public: // CefSchemeHandlerFactory
+    CefRefPtr<CefResourceHandler> Create(CefRefPtr<CefBrowser> browser,
+                                         CefRefPtr<CefFrame> frame,
+                                         const CefString& scheme_name,
+                                         CefRefPtr<CefRequest> request) override;
+
+private:
+    // decompressed once, on the CEF runtime thread
+    juce::SharedResourcePointer<UiBundle> mBundle;
+
+    IMPLEMENT_REFCOUNTING(UiSchemeHandlerFactory);
+};
@@ -0,0 +1,237 @@
+#include "WaveformPyramid.h"
+#if JUCE_INTEL
+ #include <xmmintrin.h>
+#endif
+
+namespace
+{
+    // Neither compiler vectorises the scalar sum without /fp:fast or
+    // -ffast-math, as that reorders the additions, so it is spelt out.
+    float sumOfSquares(const float* samples, int numSamples)
+    {
+        int i = 0;
+        float sum = 0.f;
+#if JUCE_INTEL
+        __m128 sum4 = _mm_setzero_ps();
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(samples + i);
+            sum4 = _mm_add_ps(sum4, _mm_mul_ps(x, x));
+        }
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        sum = _mm_cvtss_f32(sum4);
+#endif
+        for (; i < numSamples; ++i)
+        {
+            sum += samples[i] * samples[i];
+        }
+        return sum;
+    }
+}
+
+WaveformPyramid::WaveformPyramid()
+    : mCurrent(empty())
+    , mFifo(kFifoColumns)
+    , mFifoColumns(kFifoColumns)
+    , mDroppedColumns(0)
+    , mResetRequested(false)
+{
+    for (Level& level : mLevels)
+    {
+        level.columns.allocate(kColumnsPerLevel, true);
+        level.written = 0;
+        level.pending = empty();
+        level.pendingChildren = 0;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void WaveformPyramid::reset()
+{
+    // Honoured by the reader on its next update(), the audio thread only drops
+    // its partial column.
+    mCurrent = empty();
+    mResetRequested = true;
+}
+
+void WaveformPyramid::pushBlock(const juce::AudioBuffer<float>& buffer)
+{
+    const int numChannels = buffer.getNumChannels();
+    const int numSamples = buffer.getNumSamples();
+    if (numChannels == 0)
+    {
+        return;
+    }
+
+    int position = 0;
+    while (position < numSamples)
+    {
+        const int chunk = std::min(numSamples - position, kBaseSamplesPerColumn - mCurrent.numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const float* samples = buffer.getReadPointer(channel, position);
+
+            const juce::Range<float> range = juce::FloatVectorOperations::findMinAndMax(samples, chunk);
+            mCurrent.min = std::min(mCurrent.min, range.getStart());
+            mCurrent.max = std::max(mCurrent.max, range.getEnd());
+
+            mCurrent.sumSquares += sumOfSquares(samples, chunk) / (float)numChannels;
+        }
+
+        mCurrent.numSamples += chunk;
+        position += chunk;
+
+        if (mCurrent.numSamples == kBaseSamplesPerColumn)
+        {
+            int start1, size1, start2, size2;
+            mFifo.prepareToWrite(1, start1, size1, start2, size2);
+            if (size1 == 1)
+            {
+                mFifoColumns[start1] = mCurrent;
+                mFifo.finishedWrite(1);
+            }
+            else
+            {
+                mDroppedColumns.fetch_add(1, std::memory_order_relaxed);
+            }
+            mCurrent = empty();
+        }
+    }
+}
+
+void WaveformPyramid::update()
+{
+    // the other thread drains everything there is
+    const juce::SpinLock::ScopedTryLockType tl(mUpdateLock);
+    if (!tl.isLocked())
+    {
+        return;
+    }
+
+    if (mResetRequested.exchange(false))
+    {
+        for (Level& level : mLevels)
+        {
+            level.written = 0;
+            level.pending = empty();
+            level.pendingChildren = 0;
+        }
+        mFifo.finishedRead(mFifo.getNumReady());
+    }
+
+    int start1, size1, start2, size2;
+    mFifo.prepareToRead(mFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+    {
+        appendToLevel(0, mFifoColumns[start1 + i]);
+    }
+    for (int i = 0; i < size2; ++i)
+    {
+        appendToLevel(0, mFifoColumns[start2 + i]);
+    }
+
+    mFifo.finishedRead(size1 + size2);
+}
+
+void WaveformPyramid::appendToLevel(int levelIndex, const Column& column)
+{
+    Level& level = mLevels[levelIndex];
+
+    const juce::int64 written = level.written.load(std::memory_order_relaxed);
+    level.columns[(int)(written % kColumnsPerLevel)] = column;
+    level.written.store(written + 1, std::memory_order_release);
+
+    if (levelIndex + 1 < kNumLevels)
+    {
+        merge(level.pending, column);
+        if (++level.pendingChildren == kLevelRatio)
+        {
+            appendToLevel(levelIndex + 1, level.pending);
+            level.pending = empty();
+            level.pendingChildren = 0;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+int WaveformPyramid::getSamplesPerColumn(int level)
+{
+    int samples = kBaseSamplesPerColumn;
+    for (int i = 0; i < level; ++i)
+    {
+        samples *= kLevelRatio;
+    }
+    return samples;
+}
+
+int WaveformPyramid::findLevelForSamplesPerPixel(double samplesPerPixel)
+{
+    // finest level that still has at most one column per pixel
+    for (int level = 0; level < kNumLevels; ++level)
+    {
+        if (getSamplesPerColumn(level) >= samplesPerPixel)
+        {
+            return level;
+        }
+    }
+    return kNumLevels - 1;
+}
+
+juce::int64 WaveformPyramid::getWritePosition(int level) const
+{
+    jassert(juce::isPositiveAndBelow(level, (int)kNumLevels));
+    return mLevels[level].written.load(std::memory_order_acquire);
+}
+
+int WaveformPyramid::readColumns(int level, juce::int64& ioReadPosition, Column* dest, int maxColumns) const
+{
+    const juce::int64 written = getWritePosition(level);
+
+    // keep a little margin, the writer may be overwriting the oldest slot
+    const juce::int64 oldest = std::max<juce::int64>(0, written - kColumnsPerLevel + 1);
+    if (ioReadPosition < oldest || ioReadPosition > written)
+    {
+        ioReadPosition = oldest;
+    }
+
+    const int numColumns = (int)std::min<juce::int64>(written - ioReadPosition, maxColumns);
+    const Column* columns = mLevels[level].columns;
+    for (int i = 0; i < numColumns; ++i)
+    {
+        dest[i] = columns[(int)((ioReadPosition + i) % kColumnsPerLevel)];
+    }
+
+    ioReadPosition += numColumns;
+    return numColumns;
+}
+
+int WaveformPyramid::readLatest(int level, Column* dest, int numColumns) const
+{
+    juce::int64 position = getWritePosition(level) - std::min(numColumns, kColumnsPerLevel - 1);
+    return readColumns(level, position, dest, numColumns);
+}
+
+// ----------------------------------------------------------------------------
+
+void WaveformPyramid::merge(Column& target, const Column& source)
+{
+    target.min = std::min(target.min, source.min);
+    target.max = std::max(target.max, source.max);
+    target.sumSquares += source.sumSquares;
+    target.numSamples += source.numSamples;
+}
+
+WaveformPyramid::Column WaveformPyramid::empty()
+{
+    Column column;
+    column.min = std::numeric_limits<float>::max();
+    column.max = -std::numeric_limits<float>::max();
+    column.sumSquares = 0.f;
+    column.numSamples = 0;
+    return column;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include "../JuceLibraryCode/JuceHeader.h"
+
+/**
+    Multi-resolution min/max/RMS envelope of the processed signal.
+
+    The audio thread reduces each block into base-level columns and pushes them
+    through a lock-free FIFO. update() drains that FIFO, one thread at a time,
+    and cascades the columns into coarser levels, each stored in a fixed-size
+    ring, so a view of N pixels at any zoom level costs O(N) to read.
+*/
+class WaveformPyramid
+{
+public:
+    struct Column
+    {
+        float min;
+        float max;
+        float sumSquares;
+        int   numSamples;
+
+        float getRms() const
+        {
+            return numSamples > 0 ? std::sqrt(sumSquares / (float)numSamples) : 0.f;
+        }
+    };
+
+    enum
+    {
+        kNumLevels = 8,
+        kBaseSamplesPerColumn = 32,
+        kLevelRatio = 4,
+        kColumnsPerLevel = 2048,
+        kFifoColumns = 8192
+    };
+
+    WaveformPyramid();
+
+public:
+    void reset();
+
+    // Audio thread only.
+    void pushBlock(const juce::AudioBuffer<float>& buffer);
+
+    // Drains the FIFO and fills every level. Calls from several threads are
+    // serialised, one made while another thread updates returns right away.
+    void update();
+
+public:
+    static int getSamplesPerColumn(int level);
+    static int findLevelForSamplesPerPixel(double samplesPerPixel);
+
+    // Total number of columns ever written to a level.
+    juce::int64 getWritePosition(int level) const;
+
+    // Copies the columns written since ioReadPosition and advances it. Columns
+    // that have already been overwritten in the ring are skipped.
+    int readColumns(int level, juce::int64& ioReadPosition, Column* dest, int maxColumns) const;
+
+    // Copies the newest numColumns columns of a level, oldest first.
+    int readLatest(int level, Column* dest, int numColumns) const;
+
+    int getNumDroppedColumns() const { return mDroppedColumns.load(std::memory_order_relaxed); }
+
+private:
+    static void merge(Column& target, const Column& source);
+    static Column empty();
+
+    void appendToLevel(int level, const Column& column);
+
+private:
+    struct Level
+    {
+        juce::HeapBlock<Column>     columns;
+        std::atomic<juce::int64>    written;
+        Column                      pending;
+        int                         pendingChildren;
+    };
+
+    // audio thread state
+    Column                          mCurrent;
+    juce::AbstractFifo              mFifo;
+    juce::HeapBlock<Column>         mFifoColumns;
+    std::atomic<int>                mDroppedColumns;
+    std::atomic<bool>               mResetRequested;
+
+    // reader thread state, owned by whoever holds mUpdateLock
+    Level                           mLevels[kNumLevels];
+    juce::SpinLock                  mUpdateLock;
+
+    JUCE_DECLARE_NON_COPYABLE(WaveformPyramid)
+};
@@ -0,0 +1,29 @@
+/*
+    Chromium's renderer, GPU and utility processes for CEFPlugIn.
+
+    Installed next to the plugin binary as CEFPlugInHelper, CefRuntime points
+    browser_subprocess_path at it so Chromium never starts copies of the host.
+    It only runs CefExecuteProcess() with the renderer side of the plugin, no
+    audio or UI code is linked in.
+*/
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/RendererApp.h"
+
+#if JUCE_MSVC
+ // a console subsystem binary would flash a console window for every subprocess
+ #pragma comment(linker, "/SUBSYSTEM:WINDOWS /ENTRY:mainCRTStartup")
+#endif
+
+int main (int argc, char* argv[])
+{
+#if JUCE_WINDOWS
+    juce::ignoreUnused (argc, argv);
+    CefMainArgs args (GetModuleHandle (nullptr));
+#else
+    CefMainArgs args (argc, argv);
+#endif
+
+    CefRefPtr<RendererApp> app (new RendererApp());
+    return CefExecuteProcess (args, app.get(), nullptr);
+}
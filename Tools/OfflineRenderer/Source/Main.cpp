@@ -0,0 +1,391 @@
+/*
+    Offline, faster than real-time renderer for GainProcessor.
+
+    Every input file is rendered by its own headless processor instance on a
+    pool of worker threads, so no BrowserManager or UI is ever created. Reads
+    go through a read-ahead BufferingAudioReader and writes through a
+    ThreadedWriter, both fed in large blocks.
+*/
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "../../../Source/GainProcessor.h"
+
+struct RenderOptions
+{
+    juce::File                      outputDirectory;
+    int                             numJobs = juce::SystemStats::getNumCpus();
+    int                             blockSize = 8192;
+    int                             readAheadSamples = 1 << 20;
+    juce::StringPairArray           parameters;
+};
+
+// ----------------------------------------------------------------------------
+
+class RenderJob
+    : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(const juce::File& inInput, const RenderOptions& inOptions,
+              juce::AudioFormatManager& inFormats, juce::TimeSliceThread& inReadThread, juce::TimeSliceThread& inWriteThread)
+        : juce::ThreadPoolJob(inInput.getFileName())
+        , mInput(inInput)
+        , mOptions(inOptions)
+        , mFormats(inFormats)
+        , mReadThread(inReadThread)
+        , mWriteThread(inWriteThread)
+        , mAudioSeconds(0)
+        , mWallSeconds(0)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        const double start = juce::Time::getMillisecondCounterHiRes();
+        mError = render();
+        mWallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        return jobHasFinished;
+    }
+
+public:
+    const juce::File& getInput() const   { return mInput; }
+    const juce::String& getError() const { return mError; }
+    double getAudioSeconds() const       { return mAudioSeconds; }
+    double getWallSeconds() const        { return mWallSeconds; }
+
+private:
+    juce::String render()
+    {
+        juce::AudioFormatReader* sourceReader = mFormats.createReaderFor(mInput);
+        if (sourceReader == nullptr)
+        {
+            return "unsupported or unreadable file";
+        }
+
+        const double sampleRate = sourceReader->sampleRate;
+        const int numChannels = (int)sourceReader->numChannels;
+        const juce::int64 length = sourceReader->lengthInSamples;
+        const int bitsPerSample = sourceReader->bitsPerSample >= 32 ? 32 : 24;
+
+        juce::BufferingAudioReader reader(sourceReader, mReadThread, mOptions.readAheadSamples);
+        reader.setReadTimeout(10000);
+
+        const juce::File output = getOutputFile();
+        output.deleteFile();
+        juce::ScopedPointer<juce::FileOutputStream> stream(output.createOutputStream());
+        if (stream == nullptr)
+        {
+            return "cannot write " + output.getFullPathName();
+        }
+
+        juce::WavAudioFormat wav;
+        juce::AudioFormatWriter* fileWriter = wav.createWriterFor(stream, sampleRate, (unsigned int)numChannels,
+                                                                  bitsPerSample, juce::StringPairArray(), 0);
+        if (fileWriter == nullptr)
+        {
+            return "cannot create a writer for " + output.getFullPathName();
+        }
+        stream.release();
+        juce::AudioFormatWriter::ThreadedWriter writer(fileWriter, mWriteThread, mOptions.readAheadSamples);
+
+        GainProcessor processor;
+        applyParameters(processor);
+        processor.setRateAndBufferSizeDetails(sampleRate, mOptions.blockSize);
+        processor.prepareToPlay(sampleRate, mOptions.blockSize);
+
+        juce::AudioBuffer<float> storage(numChannels, mOptions.blockSize);
+        juce::MidiBuffer midi;
+
+        juce::int64 position = 0;
+        while (position < length)
+        {
+            if (shouldExit())
+            {
+                return "cancelled";
+            }
+
+            const int numSamples = (int)std::min<juce::int64>(mOptions.blockSize, length - position);
+            juce::AudioBuffer<float> block(storage.getArrayOfWritePointers(), numChannels, numSamples);
+            reader.read(&block, 0, numSamples, position, true, true);
+
+            processor.processBlock(block, midi);
+            midi.clear();
+
+            // the writer's FIFO is full, let the background thread catch up
+            while (!writer.write(block.getArrayOfReadPointers(), numSamples))
+            {
+                juce::Thread::sleep(1);
+            }
+
+            position += numSamples;
+        }
+
+        processor.releaseResources();
+        mAudioSeconds = (double)length / sampleRate;
+        return juce::String();
+    }
+
+    juce::File getOutputFile() const
+    {
+        const juce::String name = mInput.getFileNameWithoutExtension();
+        if (mOptions.outputDirectory == juce::File())
+        {
+            return mInput.getSiblingFile(name + "_rendered.wav");
+        }
+        return mOptions.outputDirectory.getChildFile(name + ".wav");
+    }
+
+    void applyParameters(GainProcessor& processor) const
+    {
+        const juce::StringArray& ids = mOptions.parameters.getAllKeys();
+        for (juce::AudioProcessorParameter* param : processor.getParameters())
+        {
+            juce::AudioParameterFloat* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param);
+            if (floatParam != nullptr && ids.contains(floatParam->paramID))
+            {
+                *floatParam = mOptions.parameters[floatParam->paramID].getFloatValue();
+            }
+        }
+    }
+
+private:
+    const juce::File            mInput;
+    const RenderOptions&        mOptions;
+    juce::AudioFormatManager&   mFormats;
+    juce::TimeSliceThread&      mReadThread;
+    juce::TimeSliceThread&      mWriteThread;
+
+    juce::String                mError;
+    double                      mAudioSeconds;
+    double                      mWallSeconds;
+};
+
+// ----------------------------------------------------------------------------
+
+static void printUsage()
+{
+    std::cout << "usage: OfflineRenderer [options] <input files...>\n"
+                 "  -o <dir>            output directory (default: <input>_rendered.wav next to the input)\n"
+                 "  -j <n>              number of files rendered in parallel (default: number of cores)\n"
+                 "  -b <samples>        processing block size (default: 8192)\n"
+                 "  -p <id>=<value>     parameter value in its own units, e.g. -p gain=0.8\n"
+                 "  --run-tests [cat]   run the unit tests, optionally only one category,\n"
+                 "                      RealtimeSafety needs the Test configuration\n"
+                 "  --bench-state [n]   save and restore the state of n instances (default: 500)\n";
+}
+
+static int runUnitTests(const juce::String& category)
+{
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    if (category.isEmpty())
+    {
+        runner.runAllTests();
+    }
+    else
+    {
+        runner.runTestsInCategory(category);
+    }
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        failures += runner.getResult(i)->failures;
+    }
+    return failures > 0 ? 1 : 0;
+}
+
+// Saves and restores the state of many headless instances, as a host does with
+// a large session, and checks that each one survives the trip.
+static int runStateBenchmark(int numInstances)
+{
+    enum
+    {
+        kUiStateSize = 16 * 1024,
+        kNumRounds = 20
+    };
+
+    juce::Random random;
+    juce::HeapBlock<char> uiState(kUiStateSize);
+    juce::OwnedArray<GainProcessor> sources;
+    juce::OwnedArray<GainProcessor> targets;
+    for (int i = 0; i < numInstances; ++i)
+    {
+        GainProcessor* source = sources.add(new GainProcessor());
+        for (juce::AudioProcessorParameter* param : source->getParameters())
+        {
+            param->setValue(random.nextFloat());
+        }
+        random.fillBitsRandomly(uiState, kUiStateSize);
+        source->getState().setUiState(uiState, kUiStateSize);
+        targets.add(new GainProcessor());
+    }
+
+    // blocks are reused from the second round on, as hosts tend to
+    std::vector<juce::MemoryBlock> states((size_t)numInstances);
+    double saveMs = 0;
+    double loadMs = 0;
+    for (int round = 0; round < kNumRounds; ++round)
+    {
+        double start = juce::Time::getMillisecondCounterHiRes();
+        for (int i = 0; i < numInstances; ++i)
+        {
+            sources[i]->getStateInformation(states[(size_t)i]);
+        }
+        saveMs += juce::Time::getMillisecondCounterHiRes() - start;
+
+        start = juce::Time::getMillisecondCounterHiRes();
+        for (int i = 0; i < numInstances; ++i)
+        {
+            targets[i]->setStateInformation(states[(size_t)i].getData(), (int)states[(size_t)i].getSize());
+        }
+        loadMs += juce::Time::getMillisecondCounterHiRes() - start;
+    }
+
+    int numMismatches = 0;
+    size_t bytes = 0;
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const juce::OwnedArray<juce::AudioProcessorParameter>& sourceParams = sources[i]->getParameters();
+        const juce::OwnedArray<juce::AudioProcessorParameter>& targetParams = targets[i]->getParameters();
+        bool same = sources[i]->getState().getUiState() == targets[i]->getState().getUiState();
+        for (int p = 0; p < sourceParams.size(); ++p)
+        {
+            // normalised values may come back an ulp off through the range
+            same = same && std::abs(sourceParams[p]->getValue() - targetParams[p]->getValue()) < 1.0e-5f;
+        }
+        numMismatches += same ? 0 : 1;
+        bytes += states[(size_t)i].getSize();
+    }
+
+    const double totalMB = (double)bytes * kNumRounds / (1024.0 * 1024.0);
+    const double numStates = (double)numInstances * kNumRounds;
+    std::cout << numInstances << " instances, " << (int)(bytes / (size_t)juce::jmax(1, numInstances)) << " bytes of state each" << std::endl
+              << "save: " << juce::String(totalMB / juce::jmax(1.0e-6, saveMs / 1000.0), 1) << " MB/s, "
+              << juce::String(saveMs * 1000.0 / numStates, 2) << " us per instance" << std::endl
+              << "load: " << juce::String(totalMB / juce::jmax(1.0e-6, loadMs / 1000.0), 1) << " MB/s, "
+              << juce::String(loadMs * 1000.0 / numStates, 2) << " us per instance" << std::endl;
+    if (numMismatches > 0)
+    {
+        std::cout << numMismatches << " instances did not restore their state" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    RenderOptions options;
+    juce::Array<juce::File> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--run-tests")
+        {
+            return runUnitTests(hasValue ? juce::String(argv[i + 1]) : juce::String());
+        }
+        else if (arg == "--bench-state")
+        {
+            return runStateBenchmark(hasValue ? juce::jmax(1, juce::String(argv[i + 1]).getIntValue()) : 500);
+        }
+        else if (arg == "-o" && hasValue)
+        {
+            options.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+        }
+        else if (arg == "-j" && hasValue)
+        {
+            options.numJobs = juce::jmax(1, juce::String(argv[++i]).getIntValue());
+        }
+        else if (arg == "-b" && hasValue)
+        {
+            options.blockSize = juce::jlimit(32, 1 << 16, juce::String(argv[++i]).getIntValue());
+        }
+        else if (arg == "-p" && hasValue)
+        {
+            const juce::String assignment(argv[++i]);
+            options.parameters.set(assignment.upToFirstOccurrenceOf("=", false, false),
+                                   assignment.fromFirstOccurrenceOf("=", false, false));
+        }
+        else if (arg.startsWith("-"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+        {
+            inputs.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+        }
+    }
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.outputDirectory != juce::File())
+    {
+        options.outputDirectory.createDirectory();
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    juce::TimeSliceThread readThread("Render read-ahead");
+    juce::TimeSliceThread writeThread("Render writer");
+    readThread.startThread(6);
+    writeThread.startThread(6);
+
+    juce::OwnedArray<RenderJob> jobs;
+    const double start = juce::Time::getMillisecondCounterHiRes();
+    {
+        juce::ThreadPool pool(juce::jmin(options.numJobs, inputs.size()));
+        for (const juce::File& input : inputs)
+        {
+            pool.addJob(jobs.add(new RenderJob(input, options, formats, readThread, writeThread)), false);
+        }
+
+        while (pool.getNumJobs() > 0)
+        {
+            juce::Thread::sleep(50);
+        }
+    }
+    const double wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+
+    // the threaded writers flush as they are destroyed, stop the threads after
+    readThread.stopThread(5000);
+    writeThread.stopThread(5000);
+
+    double audioSeconds = 0;
+    int numFailed = 0;
+    for (RenderJob* job : jobs)
+    {
+        if (job->getError().isNotEmpty())
+        {
+            std::cout << job->getInput().getFullPathName() << ": " << job->getError() << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        audioSeconds += job->getAudioSeconds();
+        std::cout << job->getInput().getFileName() << ": "
+                  << juce::String(job->getAudioSeconds(), 1) << " s in "
+                  << juce::String(job->getWallSeconds(), 2) << " s ("
+                  << juce::String(job->getAudioSeconds() / juce::jmax(1.0e-6, job->getWallSeconds()), 1) << "x realtime)"
+                  << std::endl;
+    }
+
+    std::cout << "total: " << juce::String(audioSeconds, 1) << " s of audio in "
+              << juce::String(wallSeconds, 2) << " s ("
+              << juce::String(audioSeconds / juce::jmax(1.0e-6, wallSeconds), 1) << "x realtime) on "
+              << juce::jmin(options.numJobs, inputs.size()) << " threads" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}